@@ -0,0 +1,108 @@
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+
+typedef std::chrono::steady_clock bench_clock;
+
+BenchRunner::BenchRunner(double minSeconds_, const std::string& filter_)
+    : minSeconds(minSeconds_), filter(filter_) {}
+
+bool BenchRunner::selected(const std::string& name) const {
+    return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void BenchRunner::run(const std::string& name, double items, const std::function<void()>& fn) {
+    if (!selected(name))
+        return;
+
+    fn(); // warm up caches and lazily built state
+
+    long iterations = 1;
+    while (true) {
+        unsigned long allocs = allocationCount();
+        unsigned long bytes = allocationBytes();
+        bench_clock::time_point start = bench_clock::now();
+        for (long i = 0; i < iterations; i++) {
+            fn();
+        }
+        double elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+        if (elapsed >= minSeconds || iterations >= (1L << 30)) {
+            report({name, iterations,
+                elapsed * 1e9 / iterations,
+                double(allocationCount() - allocs) / iterations,
+                double(allocationBytes() - bytes) / iterations,
+                items * iterations / elapsed});
+            return;
+        }
+        // Aim a bit past minSeconds so the next batch is usually the last
+        double scale = elapsed > 0.0 ? 1.4 * minSeconds / elapsed : 10.0;
+        iterations = std::max(iterations * 2, long(iterations * std::min(scale, 100.0)));
+    }
+}
+
+void BenchRunner::runWithSetup(const std::string& name, double items,
+        const std::function<void()>& setup, const std::function<void()>& fn) {
+    if (!selected(name))
+        return;
+
+    setup();
+    fn();
+
+    long iterations = 0;
+    double elapsed = 0.0;
+    unsigned long allocs = 0;
+    unsigned long bytes = 0;
+    while (elapsed < minSeconds) {
+        setup();
+        unsigned long startAllocs = allocationCount();
+        unsigned long startBytes = allocationBytes();
+        bench_clock::time_point start = bench_clock::now();
+        fn();
+        elapsed += std::chrono::duration<double>(bench_clock::now() - start).count();
+        allocs += allocationCount() - startAllocs;
+        bytes += allocationBytes() - startBytes;
+        iterations++;
+    }
+    report({name, iterations,
+        elapsed * 1e9 / iterations,
+        double(allocs) / iterations,
+        double(bytes) / iterations,
+        items * iterations / elapsed});
+}
+
+void BenchRunner::report(const BenchResult& result) {
+    results.push_back(result);
+    std::cerr << std::left << std::setw(36) << result.name << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << result.ns_per_op << " ns/op"
+              << std::setw(12) << result.allocs_per_op << " allocs/op"
+              << std::setprecision(0)
+              << std::setw(14) << result.items_per_second << " items/s" << std::endl;
+}
+
+void BenchRunner::writeJson(std::ostream& out, unsigned seed) const {
+#ifdef __OPTIMIZE__
+    const bool optimized = true;
+#else
+    const bool optimized = false;
+#endif
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"seed\": " << seed << ",\n  \"optimized\": " << (optimized ? "true" : "false")
+        << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"allocs_per_op\": " << r.allocs_per_op
+            << ", \"bytes_per_op\": " << r.bytes_per_op
+            << ", \"items_per_second\": " << r.items_per_second << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
@@ -0,0 +1,46 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "alloc/alloc_counter.h"
+
+struct BenchResult {
+    std::string name;
+    long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+    double items_per_second;    // items is whatever one op processes (boids, samples, ...)
+};
+
+// Minimal benchmark runner. Each benchmark is repeated until it has run for
+// at least minSeconds, heap allocations are counted through a global operator new.
+class BenchRunner {
+public:
+    BenchRunner(double minSeconds_ = 0.5, const std::string& filter_ = "");
+
+    // Times batches of fn back to back, for ops that leave their inputs reusable
+    void run(const std::string& name, double items, const std::function<void()>& fn);
+
+    // Calls setup (untimed, allocations not counted) before every op, for ops
+    // that consume or modify their inputs
+    void runWithSetup(const std::string& name, double items,
+        const std::function<void()>& setup, const std::function<void()>& fn);
+
+    const std::vector<BenchResult>& getResults() const { return results; };
+    void writeJson(std::ostream& out, unsigned seed) const;
+
+private:
+    bool selected(const std::string& name) const;
+    void report(const BenchResult& result);
+
+    double minSeconds;
+    std::string filter;
+    std::vector<BenchResult> results;
+};
+
+#endif // !BENCH_H
@@ -0,0 +1,229 @@
+// Micro-benchmarks for the simulation hot paths, see bench/README.md
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "bench.h"
+#include "shapes/boid.h"
+#include "shapes/box.h"
+#include "shapes/bullet.h"
+#include "algorithm/flock.h"
+#include "algorithm/sdf.h"
+#include "algorithm/visibility.h"
+#include "algorithm/sensing.h"
+#include "algorithm/morton.h"
+#include "algorithm/nearest.h"
+#include "algorithm/simplify.h"
+#include "utils/generation.h"
+#include "utils/profiler.h"
+
+typedef std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> boid_map_t;
+typedef std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>> box_map_t;
+
+#define BENCH_WORLD_SIZE 25.0f     // Boids and boxes are placed in [-size, size]^3
+#define BENCH_NUM_BOXES 50
+
+static void freeBoxes(box_map_t& box_map) {
+    for (auto& [cell, obstacles] : box_map) {
+        for (Obstacle* obstacle : obstacles) {
+            delete obstacle;
+        }
+    }
+    box_map.clear();
+}
+
+static void benchBoids(BenchRunner& runner, unsigned seed, box_map_t& box_map, const DistanceField& field, int count) {
+    std::mt19937 gen(seed + count);
+    // Spawned like the game's boids, around the origin and outside the boxes
+    boid_map_t pristine;
+    unsigned long next_id = 0;
+    generateRandomBoids(pristine, count, static_cast<int>(BENCH_WORLD_SIZE), box_map, 0, glm::vec3(0.0f), seed + count, next_id);
+    const std::string suffix = "/" + std::to_string(count);
+    boid_map_t boid_map;
+    long frame = 0;
+
+    // Steady state: boids already sorted, most of them stay in their cell
+    MortonOrder order;
+    int num_boids = 0;
+    boid_map_t sorted = recalculateCells(pristine, num_boids, order, frame);
+    runner.runWithSetup("recalculateCells" + suffix, count,
+        [&]() { boid_map = sorted; },
+        [&]() { boid_map = recalculateCells(std::move(boid_map), num_boids, order, ++frame); });
+
+    runner.run("getCenter" + suffix, count, [&]() {
+        std::unordered_map<std::tuple<int,int,int>, glm::vec3> centers = getCenter(pristine);
+        if (centers.empty())
+            std::abort();
+    });
+
+    // One frame of Boid::act over every boid, the goal sits in the middle of the flock
+    VisibilityCache visibility(field);
+    SensingScheduler sensing;
+    std::unordered_map<std::tuple<int,int,int>, glm::vec3> centers = getCenter(pristine);
+    glm::vec3 goal(0.0f);
+    runner.runWithSetup("Boid::act" + suffix, count,
+        [&]() { boid_map = pristine; },
+        [&]() {
+            visibility.update(goal);
+            sensing.beginFrame();
+            for (auto& [cell, boids] : boid_map) {
+                glm::vec3 center = centers[cell];
+                for (Boid& boid : boids) {
+                    boid.act(frame, goal, field, visibility, sensing, center, boids);
+                }
+            }
+            frame++;
+        });
+
+    // Shots fired from the middle of the flock in seeded directions
+    std::uniform_real_distribution<float> dirDist(-1.0f, 1.0f);
+    glm::vec3 shotDirection(dirDist(gen), dirDist(gen), dirDist(gen));
+    runner.runWithSetup("Bullet" + suffix, 1,
+        [&]() {
+            boid_map = pristine;
+            shotDirection = glm::vec3(dirDist(gen), dirDist(gen), dirDist(gen));
+        },
+        [&]() {
+            Bullet bullet(glm::vec3(0.0f), shotDirection, boid_map, 20, 0.2f);
+            if (bullet.getTrail().empty())
+                std::abort();
+        });
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [--seed N] [--min-time SECONDS] [--filter SUBSTRING] [--json PATH]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    unsigned seed = 1;
+    double minSeconds = 0.5;
+    std::string filter;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            minSeconds = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::mt19937 gen(seed);
+    BenchRunner runner(minSeconds, filter);
+
+    box_map_t box_map = generateRandomBoxes(BENCH_NUM_BOXES, 1.5f, BENCH_WORLD_SIZE, seed);
+    DistanceField field;
+    field.build(box_map);
+
+    for (int count : {100, 1000, 10000}) {
+        benchBoids(runner, seed, box_map, field, count);
+    }
+
+    // Obstacle queries: raw field samples and uncached sphere traces to the goal cell
+    std::uniform_real_distribution<float> posDist(-BENCH_WORLD_SIZE, BENCH_WORLD_SIZE);
+    std::vector<glm::vec3> samplePoints(4096);
+    for (glm::vec3& p : samplePoints) {
+        p = glm::vec3(posDist(gen), posDist(gen), posDist(gen));
+    }
+    runner.run("DistanceField::sample", samplePoints.size(), [&]() {
+        float sum = 0.0f;
+        glm::vec3 gradient;
+        for (const glm::vec3& p : samplePoints) {
+            sum += field.sample(p, &gradient);
+        }
+        if (sum < -1e30f)
+            std::abort();
+    });
+
+    VisibilityCache visibility(field);
+    std::vector<std::tuple<int,int,int>> traceCells;
+    for (size_t i = 0; i < 256; i++) {
+        traceCells.push_back(positionToCell(samplePoints[i]));
+    }
+    runner.run("VisibilityCache::trace", traceCells.size(), [&]() {
+        visibility.update(glm::vec3(0.0f));
+        visibility.invalidate();
+        for (const std::tuple<int,int,int>& cell : traceCells) {
+            visibility.visible(cell);
+        }
+    });
+
+    // Nearest sampled vertex on a sphere shell, the lookup loadModel does per dropped vertex
+    std::vector<glm::vec3> shell(20000);
+    for (glm::vec3& p : shell) {
+        p = glm::normalize(glm::vec3(posDist(gen), posDist(gen), posDist(gen)) + glm::vec3(1e-3f)) * BENCH_WORLD_SIZE;
+    }
+    PointGrid grid(shell);
+    runner.run("PointGrid::nearest", samplePoints.size(), [&]() {
+        long sum = 0;
+        for (const glm::vec3& p : samplePoints) {
+            sum += grid.nearest(glm::normalize(p) * BENCH_WORLD_SIZE);
+        }
+        if (sum < 0)
+            std::abort();
+    });
+
+    // Full LOD chain of a 64x64 wavy grid, what loadModel does once per model
+    const int side = 64;
+    std::vector<float> terrain;
+    std::vector<uint32_t> terrainIndices;
+    for (int i = 0; i <= side; i++) {
+        for (int j = 0; j <= side; j++) {
+            terrain.insert(terrain.end(), {float(i), std::sin(i * 0.3f) * std::cos(j * 0.2f), float(j), 0.0f, 1.0f, 0.0f});
+        }
+    }
+    for (int i = 0; i < side; i++) {
+        for (int j = 0; j < side; j++) {
+            uint32_t a = i * (side + 1) + j, b = a + 1, c = a + side + 1, d = c + 1;
+            terrainIndices.insert(terrainIndices.end(), {a, c, b, b, c, d});
+        }
+    }
+    runner.run("buildLodChain/8192", 1, [&]() {
+        std::vector<uint32_t> chain = terrainIndices;
+        if (buildLodChain(terrain.data(), terrain.size() / 6, 6, chain, MESH_LOD_LEVELS, MESH_LOD_RATIO, 1.0f).empty())
+            std::abort();
+    });
+
+    // Cost of one empty zone, this is what instrumenting a phase adds per call
+    runner.run("ProfileZone", 1000, [&]() {
+        for (int i = 0; i < 1000; i++) {
+            PROFILE_ZONE("bench");
+        }
+    });
+
+    uint64_t pointKey = 0;
+    runner.run("getRandomPointOutsideObstacles", 1, [&]() {
+        Rng rng(seed, RNG_BOID_SPAWN, pointKey++);
+        getRandomPointOutsideObstacles(box_map, BENCH_WORLD_SIZE, 0.5f, rng);
+    });
+
+    box_map_t generated;
+    runner.runWithSetup("generateRandomBoxes/100", 100,
+        [&]() { freeBoxes(generated); },
+        [&]() { generated = generateRandomBoxes(100, 1.0f, 50.0f, seed); });
+    freeBoxes(generated);
+    freeBoxes(box_map);
+
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        if (!out) {
+            std::cerr << "Could not write " << jsonPath << std::endl;
+            return 1;
+        }
+        runner.writeJson(out, seed);
+    } else {
+        runner.writeJson(std::cout, seed);
+    }
+    return 0;
+}
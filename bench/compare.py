@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Compare a boids_bench JSON run against a stored baseline.
+
+Exits with status 1 if any benchmark got slower than the threshold or
+started allocating more per op.
+
+    ./boids_bench --json current.json
+    ../bench/compare.py ../bench/baseline.json current.json
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return data, {b["name"]: b for b in data["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed slowdown in ns/op as a fraction (default 0.10)")
+    parser.add_argument("--alloc-slack", type=float, default=0.5,
+                        help="allowed increase in allocations/op (default 0.5)")
+    args = parser.parse_args()
+
+    base_info, baseline = load(args.baseline)
+    cur_info, current = load(args.current)
+
+    if base_info.get("seed") != cur_info.get("seed"):
+        print("warning: runs used different seeds ({} vs {})".format(base_info.get("seed"), cur_info.get("seed")))
+    if not cur_info.get("optimized", True):
+        print("warning: current run is not an optimized build")
+
+    regressions = 0
+    print("{:<36} {:>14} {:>14} {:>8} {:>10} {:>10}".format(
+        "benchmark", "base ns/op", "cur ns/op", "change", "base alloc", "cur alloc"))
+    for name, cur in current.items():
+        base = baseline.get(name)
+        if base is None:
+            print("{:<36} {:>14} {:>14.1f} {:>8} {:>10} {:>10.1f}  new".format(
+                name, "-", cur["ns_per_op"], "-", "-", cur["allocs_per_op"]))
+            continue
+
+        change = cur["ns_per_op"] / base["ns_per_op"] - 1.0 if base["ns_per_op"] > 0 else 0.0
+        flags = []
+        if change > args.threshold:
+            flags.append("SLOWER")
+        if cur["allocs_per_op"] > base["allocs_per_op"] + args.alloc_slack:
+            flags.append("MORE ALLOCS")
+        regressions += 1 if flags else 0
+
+        print("{:<36} {:>14.1f} {:>14.1f} {:>+7.1f}% {:>10.1f} {:>10.1f}  {}".format(
+            name, base["ns_per_op"], cur["ns_per_op"], change * 100.0,
+            base["allocs_per_op"], cur["allocs_per_op"], " ".join(flags)))
+
+    for name in baseline:
+        if name not in current:
+            print("{:<36} missing from current run".format(name))
+
+    if regressions:
+        print("{} regression(s)".format(regressions))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
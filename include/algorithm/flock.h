@@ -5,8 +5,9 @@
 #include <vector>
 #include <unordered_map>
 #include "shapes/boid.h"
+#include "utils/generation.h"
 
-std::unordered_map<std::tuple<int, int, int>, glm::vec3> getCenter(const std::unordered_map<std::tuple<int, int, int>, std::vector<Boid>>& boid_map) {
+inline std::unordered_map<std::tuple<int, int, int>, glm::vec3> getCenter(const std::unordered_map<std::tuple<int, int, int>, std::vector<Boid>>& boid_map) {
     std::unordered_map<std::tuple<int, int, int>, glm::vec3> flock_map;
     for (const auto& [cell, boids] : boid_map) {
       glm::vec3 sum(0.0f,0.0f,0.0f);
@@ -21,5 +22,15 @@ std::unordered_map<std::tuple<int, int, int>, glm::vec3> getCenter(const std::un
 }
 
 
+// Average heading of a cell's boids, used to move far boids as one flock
+inline glm::vec3 getHeading(const std::vector<Boid>& boids) {
+    glm::vec3 sum(0.0f,0.0f,0.0f);
+    for(const Boid& boid : boids){
+      sum += boid.getDirection();
+    }
+    if(glm::length(sum) > 0.0f)
+      return glm::normalize(sum);
+    return sum;
+}
 
 #endif // !FLOCK_H
@@ -0,0 +1,19 @@
+#ifndef LOD_H
+#define LOD_H
+
+// Simulation level of detail for boids, picked from the distance to the player
+typedef enum {
+  LOD_NEAR,   // full sensing every tick
+  LOD_MID,    // full sensing every LOD_MID_INTERVAL ticks, extrapolated in between
+  LOD_FAR     // moved along with the cell's flock, no per-boid sensing, see Boid::driftFlock
+} sim_lod_t;
+
+#define LOD_NEAR_RANGE 15.0f
+#define LOD_FAR_RANGE 30.0f
+#define LOD_HYSTERESIS 2.0f    // Extra distance needed to step back down a tier
+#define LOD_MID_INTERVAL 4
+#define LOD_FLOCK_CLEARANCE 1.5f  // Far flocks at least this clear of obstacles move as one
+
+sim_lod_t selectSimLod(float distance, sim_lod_t current);
+
+#endif // !LOD_H
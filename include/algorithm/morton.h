@@ -0,0 +1,64 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <cstdint>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "shapes/boid.h"
+#include "utils/generation.h"
+
+#define MORTON_FULL_SORT_PERIOD 120   // Frames between forced full sorts
+#define MORTON_DISORDER_RATIO 16      // Insertion sort while fewer than 1/N keys are out of order
+
+// Interleaves the bits of a cell coordinate (21 bits per axis) so cells that
+// are close in space get close codes
+uint64_t mortonCode(const std::tuple<int,int,int>& cell);
+
+typedef enum {
+  SORT_NONE,
+  SORT_INSERTION,
+  SORT_FULL
+} morton_sort_t;
+
+// Orders the boid cells by the Morton code of their coordinates, so the world
+// walks cells in spatial order and neighboring cells are processed back to
+// back. Only the cell keys are sorted, boids stay in their cells' vectors.
+class MortonOrder {
+public:
+    // Sorts the cells of boid_map. Starts from the last order with new cells
+    // appended, an insertion pass fixes that up when few cells changed and a
+    // full sort runs otherwise. Codes that collide (cells past 21 bits) go by
+    // coordinate, so the order only depends on the keys.
+    void sort(const std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>>& boid_map, long int frame);
+
+    // Cells in Morton order, as of the last sort
+    const std::vector<std::tuple<int,int,int>>& getCells() const { return cells; };
+
+    morton_sort_t getLastMethod() const { return lastMethod; };
+    long getLastSortNanos() const { return lastSortNanos; };
+    size_t getLastDisorder() const { return lastDisorder; };
+
+private:
+    struct Entry {
+        uint64_t code;
+        std::tuple<int,int,int> cell;
+        bool operator<(const Entry& other) const {
+            return code != other.code ? code < other.code : cell < other.cell;
+        }
+    };
+
+    void insertionSort();
+
+    std::vector<Entry> entries;
+    std::vector<Entry> last;
+    std::vector<std::tuple<int,int,int>> cells;
+
+    long int lastFullSort = -MORTON_FULL_SORT_PERIOD;
+    morton_sort_t lastMethod = SORT_NONE;
+    long lastSortNanos = 0;
+    size_t lastDisorder = 0;
+};
+
+#endif // !MORTON_H
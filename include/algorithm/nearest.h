@@ -0,0 +1,37 @@
+#ifndef NEAREST_H
+#define NEAREST_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#define POINT_GRID_POINTS_PER_CELL 2     // target occupancy when the cell size is picked
+
+// Nearest point queries over a fixed point set. Points are bucketed into a
+// dense uniform grid over their bounds (cell starts plus one index array), a
+// query searches shells of cells outward from its own cell and stops once
+// the next shell can't hold anything closer. Close to O(1) per query for
+// evenly spread points such as mesh vertices, instead of a scan over all.
+class PointGrid {
+public:
+    PointGrid(const std::vector<glm::vec3>& points_);
+
+    // Index of the point closest to p, the lowest index on ties, -1 without points
+    long nearest(const glm::vec3& p) const;
+
+    size_t size() const { return points.size(); };
+
+private:
+    size_t cellIndex(int x, int y, int z) const { return (size_t(z) * dims[1] + y) * dims[0] + x; };
+    // Cell coordinate along axis, clamped into the grid
+    int cellOf(float coordinate, int axis) const;
+
+    std::vector<glm::vec3> points;
+    glm::vec3 origin = glm::vec3(0.0f);
+    float cellSize = 1.0f;
+    int dims[3] = {0, 0, 0};
+    std::vector<uint32_t> cellStart;    // one offset into indices per cell, plus the end
+    std::vector<uint32_t> indices;      // point indices grouped by cell, ascending in each
+};
+
+#endif // !NEAREST_H
@@ -0,0 +1,84 @@
+#ifndef SDF_H
+#define SDF_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "shapes/box.h"
+#include "utils/generation.h"
+
+#define SDF_BRICK_SIZE 8          // Voxels along each edge of a brick
+#define SDF_VOXEL_SIZE 0.5f       // World units between distance samples
+#define SDF_BAND 3.0f             // Distances are clamped to this, empty space stores no bricks
+
+// Distances of one brick baked ahead of time, (SDF_BRICK_SIZE + 1)^3 floats
+// that stay owned by whoever baked them (a mapped world file)
+struct BakedBrick {
+    std::tuple<int,int,int> key;
+    const float* distances;
+};
+
+// Sparse, bricked signed distance field over the obstacles in box_map.
+// Only bricks within SDF_BAND of an obstacle are stored, everything else
+// reads back as SDF_BAND (far from everything).
+class DistanceField {
+public:
+    DistanceField(float voxelSize_ = SDF_VOXEL_SIZE, float band_ = SDF_BAND);
+
+    // Bake the field from every obstacle in the map
+    void build(const std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map);
+
+    // Incremental updates, only the bricks touched by the obstacle are re-baked
+    void addObstacle(const Obstacle* obstacle);
+    void removeObstacle(const Obstacle* obstacle, glm::vec3 oldMin, glm::vec3 oldMax);
+    void moveObstacle(const Obstacle* obstacle, glm::vec3 oldMin, glm::vec3 oldMax);
+
+    // Batched add and remove for obstacles that never moved, a brick shared by
+    // several of them is re-baked once. Bricks in baked are used as they are
+    // instead of being re-baked, until something near them changes.
+    void addObstacles(const std::vector<Obstacle*>& obstacles, const std::vector<BakedBrick>& baked = {});
+    void removeObstacles(const std::vector<Obstacle*>& obstacles);
+
+    // Trilinear distance at point, optionally also the (normalized) gradient
+    float sample(const glm::vec3& point, glm::vec3* gradient = nullptr) const;
+
+    float getBand() const { return band; };
+    float getVoxelSize() const { return voxelSize; };
+    size_t brickCount() const { return bricks.size(); };
+    // Every stored brick, pointing into the field, for writing it out
+    std::vector<BakedBrick> bakedBricks() const;
+    // Bumped every time bricks are re-baked so dependent caches can tell the field changed
+    unsigned long getVersion() const { return version; };
+
+private:
+    typedef std::tuple<int,int,int> brick_key_t;
+
+    struct Brick {
+        // (SDF_BRICK_SIZE + 1)^3 samples so a lookup never crosses into a neighbor
+        std::vector<float> distances;
+        // Set instead of distances for a brick adopted from a BakedBrick
+        const float* baked = nullptr;
+
+        const float* data() const { return baked != nullptr ? baked : distances.data(); };
+    };
+
+    brick_key_t positionToBrick(const glm::vec3& pos) const;
+    glm::vec3 brickOrigin(const brick_key_t& key) const;
+    void markBricks(const Obstacle* obstacle, glm::vec3 minCorner, glm::vec3 maxCorner, bool insert);
+    void rebuildDirty();
+    void rebuildBrick(const brick_key_t& key);
+
+    float voxelSize;
+    float band;
+    float brickWorldSize;
+    unsigned long version = 0;
+
+    std::unordered_map<brick_key_t, Brick> bricks;
+    std::unordered_map<brick_key_t, std::vector<const Obstacle*>> brick_obstacles;
+    std::unordered_set<brick_key_t> dirty;
+};
+
+#endif // !SDF_H
@@ -0,0 +1,42 @@
+#ifndef SENSING_H
+#define SENSING_H
+
+#define SENSE_PERIOD 4              // Frames between routine refreshes of one boid
+#define SENSE_BUDGET 4096           // Most sensing work (neighbor pairs and field samples) in one frame
+#define SENSE_PRIORITY_SHARE 0.25f  // Part of the budget only priority refreshes may use
+#define SENSE_MOVE_THRESHOLD 0.5f   // Moving this far since the last sense forces a refresh
+
+// Decides which boids re-sense their obstacles and neighbors each frame.
+// Boids are refreshed round-robin once their cached perception is
+// SENSE_PERIOD frames old, and boids that moved far get priority, all
+// within a fixed per-frame budget of work units, so a crowded cell costs
+// what its neighbor pairs cost. Everyone else reuses cached results.
+class SensingScheduler {
+public:
+    SensingScheduler(int period_ = SENSE_PERIOD, long budget_ = SENSE_BUDGET,
+        float moveThreshold_ = SENSE_MOVE_THRESHOLD);
+
+    void beginFrame();
+
+    // staleness is frames since the boid last sensed, moved is the distance
+    // travelled since then and clearance the distance to the nearest obstacle it saw.
+    // cost is the work the refresh would do, the first refresh of a frame is
+    // always allowed so a cell bigger than the budget still gets sensed
+    bool shouldRefresh(long staleness, float moved, float clearance, long cost);
+
+    int getRefreshed() const { return refreshed; };
+    int getDeferred() const { return deferred; };
+    long getSpent() const { return spent; };
+    int getPeriod() const { return period; };
+
+private:
+    int period;
+    long budget;
+    float moveThreshold;
+
+    long spent = 0;
+    int refreshed = 0;
+    int deferred = 0;
+};
+
+#endif // !SENSING_H
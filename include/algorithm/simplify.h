@@ -0,0 +1,43 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define MESH_LOD_LEVELS 5               // Most levels in a chain, the full mesh included
+#define MESH_LOD_RATIO 0.5f             // Triangles of a level relative to the one before
+#define MESH_LOD_MAX_ERROR 0.05f        // Largest error a level may have, relative to the mesh's bounding radius
+#define MESH_LOD_BOUNDARY_WEIGHT 10.0f  // Quadric weight keeping open borders in place
+#define MESH_LOD_MAX_PIXELS 1.0f        // Screen error (pixels) a drawn level may show
+
+// One level of detail: a range of the mesh's index buffer over the shared
+// vertices, and how far (world units) its surface may be from the full mesh
+struct MeshLod {
+    uint32_t first_index;
+    uint32_t index_count;
+    float error;
+};
+
+// Quadric error simplification (Garland and Heckbert) into a chain of levels.
+// Edges are collapsed cheapest first onto one of their endpoints, so every
+// level indexes the same vertex buffer, and the quadrics carry over from
+// level to level so each level's error is measured against the full mesh.
+// Collapses that would flip a triangle or pinch the surface are skipped,
+// border vertices only slide along the border. Vertices at the same position
+// are welded while simplifying, seams survive where their vertices do.
+//
+// vertices holds vertexCount vertices of stride floats, position first.
+// indices holds the full mesh's triangles, the coarser levels are appended
+// to it. Each level aims for ratio times the triangles of the one before and
+// the chain ends early when that would take an error over maxError. The
+// returned levels start with the full mesh.
+std::vector<MeshLod> buildLodChain(const float* vertices, size_t vertexCount, size_t stride,
+    std::vector<uint32_t>& indices, int levels, float ratio, float maxError);
+
+// Coarsest level whose error projects to at most maxPixels on screen at this
+// distance. pixelsPerUnit is the projection's scale at distance 1, viewport
+// height / (2 tan(fovy / 2)).
+size_t selectMeshLod(const std::vector<MeshLod>& lods, float distance, float pixelsPerUnit, float maxPixels);
+
+#endif // !SIMPLIFY_H
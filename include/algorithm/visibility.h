@@ -0,0 +1,39 @@
+#ifndef VISIBILITY_H
+#define VISIBILITY_H
+
+#include <glm/glm.hpp>
+#include <tuple>
+#include <unordered_map>
+
+#include "algorithm/sdf.h"
+#include "utils/generation.h"
+
+// Caches whether a cell can see the goal (player) cell. Results are built
+// lazily and dropped whenever the goal changes cell or the obstacle field
+// is re-baked, so most boids pay a single hash probe per frame.
+class VisibilityCache {
+public:
+    VisibilityCache(const DistanceField& field_);
+
+    // Call once per frame with the goal position before any boid queries
+    void update(const glm::vec3& goal_pos);
+    void invalidate() { cache.clear(); };
+
+    bool visible(const std::tuple<int,int,int>& from_cell);
+
+    size_t getHits() const { return hits; };
+    size_t getMisses() const { return misses; };
+
+private:
+    bool traceCells(const std::tuple<int,int,int>& from_cell) const;
+
+    const DistanceField& field;
+    std::tuple<int,int,int> goal_cell;
+    unsigned long field_version;
+
+    std::unordered_map<std::tuple<int,int,int>, bool> cache;
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+#endif // !VISIBILITY_H
@@ -0,0 +1,11 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+// Heap allocations (count and bytes) since the process started, counted by
+// the global operator new in lib/alloc/alloc_counter.cpp. It replaces
+// operator new for the whole program, so it is not part of boids_core: only
+// boids_bench builds it, and the game with BOIDS_HUD_ALLOCS.
+unsigned long allocationCount();
+unsigned long allocationBytes();
+
+#endif // !ALLOC_COUNTER_H
@@ -8,7 +8,7 @@
 #include <cmath>
 
 #include "shapes/box.h"
-#include "shapes/sphere.h"
+#include "render/sphere.h"
 
 #include "utils/m_shader.h"
 
@@ -0,0 +1,76 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <GL/glew.h>
+#include <ostream>
+
+#include "utils/timer.h"
+
+#define GPU_TIMER_LATENCY 4     // frames a query gets before its result is read
+
+// Render passes timed on the GPU, in draw order
+typedef enum {
+  GPU_PASS_BOIDS,
+  GPU_PASS_COLLECTIBLES,
+  GPU_PASS_STARS,
+  GPU_PASS_OBSTACLES,
+  GPU_PASS_SUN,
+  GPU_PASS_PLANETS,
+  GPU_PASS_PLAYER,
+  GPU_PASS_COUNT
+} gpu_pass_t;
+
+const char* gpuPassName(gpu_pass_t pass);
+
+// GL_TIME_ELAPSED query rings, one query per pass per frame in flight. Results
+// are collected GPU_TIMER_LATENCY frames later, by then the GPU is done with
+// them and reading never stalls. A pass whose old query is somehow still
+// pending skips a frame instead of waiting.
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Collects finished queries into the stats, call before the first pass
+    void beginFrame();
+
+    // Time elapsed queries can't nest, passes must not overlap
+    void begin(gpu_pass_t pass);
+    void end(gpu_pass_t pass);
+
+    // False without GL 3.3 / ARB_timer_query, everything is a no-op then
+    bool isSupported() const { return supported; };
+
+    // GPU milliseconds per pass, the same stats the CPU frame times use
+    const FrameStats& getStats(gpu_pass_t pass) const { return stats[pass]; };
+
+    // One FrameStats JSON object per pass
+    void writeJson(std::ostream& out) const;
+
+private:
+    bool supported = false;
+    int slot = 0;
+    GLuint queries[GPU_TIMER_LATENCY][GPU_PASS_COUNT] = {};
+    bool pending[GPU_TIMER_LATENCY][GPU_PASS_COUNT] = {};
+    bool active[GPU_PASS_COUNT] = {};
+    FrameStats stats[GPU_PASS_COUNT];
+};
+
+// Times one pass for the rest of the scope
+class GpuPass {
+public:
+    GpuPass(GpuTimer& timer_, gpu_pass_t pass_) : timer(timer_), pass(pass_) { timer.begin(pass); }
+    ~GpuPass() { timer.end(pass); }
+
+    GpuPass(const GpuPass&) = delete;
+    GpuPass& operator=(const GpuPass&) = delete;
+
+private:
+    GpuTimer& timer;
+    gpu_pass_t pass;
+};
+
+#endif // !GPU_TIMER_H
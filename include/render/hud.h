@@ -0,0 +1,61 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "utils/m_shader.h"
+#include "utils/timer.h"
+#include "utils/world.h"
+#include "utils/counters.h"
+#include "render/gpu_timer.h"
+
+#define HUD_GRAPH_FRAMES 240    // frames shown in the frame time graph
+
+// Performance overlay: frame time graph, CPU phase and GPU pass bars, entity,
+// draw call, mesh, allocation (built with BOIDS_HUD_ALLOCS) and work counts. Everything is quads from one
+// glyph atlas, rebuilt every frame into one buffer and drawn with a single call.
+class Hud {
+public:
+    Hud();
+    ~Hud();
+
+    Hud(const Hud&) = delete;
+    Hud& operator=(const Hud&) = delete;
+
+    void toggle() { visible = !visible; };
+    bool isVisible() const { return visible; };
+
+    // Call once per frame after the scene, updates the per-frame deltas even
+    // while hidden so the first frame shown has sensible numbers
+    void draw(const World& world, const Timer& timer, const GpuTimer& gpu, int width, int height);
+
+    // Startup screen: label and a bar filled to fraction, in the middle of the screen
+    void drawProgress(const char* label, float fraction, int width, int height);
+
+private:
+    void rect(float x, float y, float w, float h, glm::vec4 color);
+    // Returns the x after the last character
+    float text(float x, float y, const char* str, glm::vec4 color);
+    float bar(float x, float y, const char* label, double ms, double fullMs, glm::vec4 color);
+    // Uploads and draws the quads built so far
+    void submit(int width, int height);
+
+    Shader shader;
+    GLuint atlas = 0;
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    std::vector<GLfloat> vertices;      // kept between frames so building never allocates
+
+    bool visible = false;
+    unsigned long last_allocs = 0;
+    unsigned long last_draws = 0;
+    CounterSample last_counters;
+    unsigned long frame_allocs = 0;
+    unsigned long frame_draws = 0;
+    CounterSample frame_counters;       // render uploads included, unlike World::frame_counters
+    double build_ms = 0.0;              // CPU time of the last overlay, shown on itself
+};
+
+#endif // !HUD_H
@@ -0,0 +1,45 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "utils/random.h"
+
+// GPU buffers for one indexed triangle mesh. Meshes are built once around the
+// origin and placed with the shader's model matrix.
+struct Mesh {
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+    GLsizei indexCount = 0;
+};
+
+// Uploads interleaved vertices, 3 position floats followed by 3 normal floats
+// when withNormals is set
+Mesh uploadMesh(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, bool withNormals);
+void drawMesh(const Mesh& mesh);
+// Draws count indices from first on, one level of a mesh whose index buffer holds several
+void drawMeshRange(const Mesh& mesh, GLuint first, GLsizei count);
+void destroyMesh(Mesh& mesh);
+
+// Running totals since startup, the HUD shows them per frame
+struct MeshStats {
+    unsigned long draw_calls;
+    long live_meshes;       // each holds a VAO, a VBO and an EBO
+};
+MeshStats meshStats();
+
+// Geometry builders, they append to vertices/indices so several shapes can be merged
+void appendSphere(float radius, glm::vec3 center, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+// Sphere with its radius roughened by noise drawn from rng, positions + normals
+void appendAsteroid(float radius, Rng& rng, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+void appendBox(float width, float height, float depth, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+// Square based pyramid pointing up +y, positions only
+void appendPyramid(float size, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+
+// Rotation that points a pyramid along direction, identity for a zero direction
+glm::mat4 pyramidOrientation(glm::vec3 direction);
+
+#endif // !MESH_H
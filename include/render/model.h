@@ -0,0 +1,17 @@
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+#include "algorithm/simplify.h"
+
+// Appends the model's vertices, keeping every vertexSampleRate-th, and sets
+// indices to its triangles. With lods set the simplified levels of
+// algorithm/simplify.h are appended to indices too and lods says where each
+// one is, sampling every vertex and picking levels keeps the mesh intact.
+void loadModel(std::vector<GLfloat>& unrotatedVertices, std::vector<GLuint>& indices, const std::string modelPath, float scale, int vertexSampleRate,
+               std::vector<MeshLod>* lods = nullptr);
+
+#endif // !MODEL_H
@@ -0,0 +1,61 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define PROGRAM_CACHE_MAGIC 0x47525042u    // "BPRG"
+#define PROGRAM_CACHE_VERSION 1
+
+// Linked program binaries from glGetProgramBinary, one file per program in
+// dir, named after a hash of the GLSL sources and the driver's vendor,
+// renderer and version strings. A driver update or an edited shader misses
+// the cache and compiles, a hit skips compiling and linking entirely.
+//
+// Programs that do compile are started without waiting for them. With
+// GL_KHR_parallel_shader_compile the driver builds them all at once on its
+// own threads, finish() then waits, reports errors and stores the binaries.
+class ProgramCache {
+public:
+    explicit ProgramCache(const std::string& dir_);
+
+    // The program for these sources, from the cache or compiling. Geometry
+    // may be empty. name labels error messages.
+    GLuint build(const std::string& name, std::string_view vertex, std::string_view fragment,
+        std::string_view geometry);
+
+    // Waits for programs still compiling, prints their errors and caches the
+    // ones that linked. Using a program before this is fine, GL waits for it.
+    void finish();
+    // True when nothing is left compiling, never blocks
+    bool ready();
+
+    unsigned getHits() const { return hits; };
+    unsigned getMisses() const { return misses; };
+
+private:
+    struct Pending {
+        GLuint program;
+        GLuint shaders[3];
+        std::string name;
+        std::string path;
+    };
+    bool load(const std::string& path, GLuint program);
+    void store(const std::string& path, GLuint program);
+
+    std::string dir;
+    std::string driver;         // vendor, renderer and version, part of every key
+    bool binaries = false;      // driver can hand out program binaries
+    bool parallel = false;
+    std::vector<Pending> pending;
+    unsigned hits = 0;
+    unsigned misses = 0;
+};
+
+// Shared by every Shader, needs a current context on first use
+ProgramCache& programCache();
+
+#endif // !PROGRAM_CACHE_H
@@ -0,0 +1,75 @@
+#ifndef WORLD_RENDERER_H
+#define WORLD_RENDERER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <tuple>
+#include <vector>
+#include <unordered_map>
+
+#include "utils/m_shader.h"
+#include "utils/world.h"
+#include "render/mesh.h"
+#include "render/gpu_timer.h"
+#include "algorithm/simplify.h"
+
+// Draws a World. Holds every GL resource so the simulation classes never touch GL,
+// needs a current context for its whole lifetime.
+class WorldRenderer {
+public:
+    WorldRenderer(GLuint sunTexture_);
+    ~WorldRenderer();
+
+    WorldRenderer(const WorldRenderer&) = delete;
+    WorldRenderer& operator=(const WorldRenderer&) = delete;
+
+    void draw(const World& world, const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos);
+    // Drops the meshes of world.evicted_obstacles. draw does it for steps,
+    // a snapshot restore evicts between draws and has to call it itself.
+    void forgetEvicted(const World& world);
+
+    // For a texture uploaded after the renderer was built
+    void setSunTexture(GLuint texture) { sunTexture = texture; };
+    // A loaded model (positions + normals, radius 1 around the origin) drawn
+    // for every asteroid in place of their procedural meshes. indices holds
+    // every level of lods, each asteroid draws the coarsest one that stays
+    // under MESH_LOD_MAX_PIXELS of error at its distance.
+    void setAsteroidModel(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices,
+        const std::vector<MeshLod>& lods);
+
+    const GpuTimer& getGpuTimer() const { return gpu_timer; };
+
+private:
+    void drawBoids(const World& world);
+    void drawCollectibles(const World& world);
+    void drawStars(const World& world);
+    void drawObstacles(const World& world, glm::vec3 cameraPos, float pixelsPerUnit);
+    void drawSun(const World& world);
+    void drawPlanets(const World& world);
+    void drawPlayer(const World& world);
+
+    // Obstacles are built once around the origin and moved with the model matrix
+    const Mesh& obstacleMesh(const Obstacle* obstacle, uint64_t seed);
+    const Mesh& planetMesh(float radius);
+
+    Shader lightingShader;
+    Shader textureShader;
+    Shader brightShader;
+    GLuint sunTexture;
+    GpuTimer gpu_timer;
+
+    Mesh pyramid;
+    Mesh sphere;            // unit sphere for collectibles, thruster and aimer
+    Mesh stars;             // all background stars merged into one draw
+    unsigned long starVersion = ~0ul;
+    Mesh asteroid_model;    // shared by every asteroid once set, scaled to each radius
+    std::vector<MeshLod> asteroid_lods;
+
+    std::unordered_map<const Obstacle*, Mesh> obstacle_meshes;
+    std::unordered_map<float, Mesh> planet_meshes;
+};
+
+// Debug wireframe around every occupied cell
+void drawChunkBorders(const std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle*>>& box_map);
+
+#endif // !WORLD_RENDERER_H
@@ -2,19 +2,12 @@
 #define ASTEROID_H
 
 #include <glm/glm.hpp>
-#include <GL/glew.h>
-#include <vector>
 #include "shapes/box.h"
-#include "utils/m_shader.h"
-
-#include <glm/vec3.hpp>
-#include <vector>
-#include <GL/glew.h>
 
 class Asteroid : public Obstacle {
 public:
-    Asteroid(float radius, glm::vec3 start_pos, float speed_);
-    void draw(Shader& shader) const override;
+    // id keys the asteroid's generated shape
+    Asteroid(float radius, glm::vec3 start_pos, float speed_, unsigned long id_ = 0);
     void updatePos(glm::vec3 next_pos);
     void setPosition(glm::vec3 pos);
     float getX() const override { return x; }
@@ -22,6 +15,9 @@ public:
     float getZ() const override { return z; }
 
     glm::vec3 getPos() const override { return glm::vec3(x, y, z); }
+    float getRadius() const { return radius; }
+    unsigned long getId() const { return id; }
+    obstacle_t getKind() const override { return OBSTACLE_ASTEROID; }
 
     float getMinX() const override { return x - radius; }
     float getMaxX() const override { return x + radius; }
@@ -38,21 +34,18 @@ public:
       return glm::distance(point, glm::vec3(x,y,z)) < radius; 
     };
 
-private:
-    void buildVertices();
-    void rebuildVertices();
+    float signedDistance(const glm::vec3& point) const override {
+      return glm::distance(point, glm::vec3(x,y,z)) - radius;
+    };
 
+private:
     float radius;
-    int sectorCount;
-    int stackCount;
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
-    GLuint VAO, VBO, EBO;
     float x;
     float y;
     float z;
     float speed;
+    unsigned long id;
 };
 
-#endif // SPHERE_H
+#endif // ASTEROID_H
 
@@ -2,28 +2,38 @@
 #define BOID_H
 
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <GL/glew.h>
 #include <vector>
 #include <cmath>
+#include <cstdint>
 
 #include "shapes/box.h"
-#include "shapes/sphere.h"
-
-#include "utils/m_shader.h"
+#include "algorithm/lod.h"
 
+class DistanceField;
+class VisibilityCache;
+class SensingScheduler;
 
 class Boid {
 public:
-    Boid(long int frame, glm::vec3 start_pos);
-
-    bool act(glm::vec3 goal_pos, std::vector<Obstacle*> obstacles, glm::vec3 flock_center, std::vector<Boid>& boids);
-    void draw(Shader& shader) const;
+    // id comes from the owner's counter (World::next_boid_id), seed only
+    // picks the color, keyed by the id
+    Boid(long int frame, glm::vec3 start_pos, unsigned long id_, uint64_t seed = 0);
+
+    bool act(long int frame, glm::vec3 goal_pos, const DistanceField& field, VisibilityCache& visibility,
+        SensingScheduler& sensing, glm::vec3 flock_center, std::vector<Boid>& boids);
+    // Picks the simulation level of detail from the distance to goal_pos and runs
+    // act, coast or drift accordingly
+    bool tick(long int frame, glm::vec3 goal_pos, const DistanceField& field, VisibilityCache& visibility,
+        SensingScheduler& sensing, glm::vec3 flock_center, glm::vec3 flock_heading, std::vector<Boid>& boids);
+    // Steps a cell whose boids are all far from goal_pos as one flock: the
+    // shared state (mean heading and speed) is updated once and every boid is
+    // moved by the same amount. False, with nothing changed, when the cell is
+    // not entirely far or is near an obstacle, tick each boid then.
+    static bool driftFlock(std::vector<Boid>& boids, glm::vec3 goal_pos,
+        glm::vec3 flock_heading, const DistanceField& field);
     glm::vec3 getPos() const { return position; };
     std::vector<glm::vec3> directions_from_view_angle(float angle);
-    void avoidObstacles(std::vector<Obstacle*> boxes, std::vector<Boid> boids);
-
-    void drawLine(glm::vec3 start, glm::vec3 end);
+    void avoidObstacles(const DistanceField& field);
 
     bool contains(glm::vec3 point) const;
 
@@ -32,36 +42,36 @@ public:
     };
 
     glm::vec3 getDirection() const { return direction; };
-    void applyFlockForces(std::vector<Boid>& boids);
+    glm::vec3 getColor() const { return glm::vec3(boidR, boidG, boidB); };
+    float getSize() const { return size; };
+    unsigned long getId() const { return id; };
+    sim_lod_t getLod() const { return lod; };
 
 private:
 
-    void buildVertices();
+    bool coast();
+    bool drift(glm::vec3 flock_center, glm::vec3 flock_heading, const DistanceField& field);
+    void senseObstacles(const DistanceField& field);
+    void senseNeighbors(const std::vector<Boid>& boids);
+    void applySensedObstacleForce();
     void applyForce(glm::vec3 force_direction, float strength);
-    glm::vec3 rotateVertex(const glm::vec3& vertex, const glm::vec3& direction);
-
-    void calculateNormals(const std::vector<glm::vec3>& unrotatedVertices);
 
     bool dead = false;
+    unsigned long id;
+    sim_lod_t lod = LOD_NEAR;
 
-    float speed = 0.0f;
+    // Cached perception, refreshed when the SensingScheduler allows it
+    long int lastSensedFrame = -1000000;
+    glm::vec3 lastSensedPos;
+    float sensedObstacleDistance = 1000000.0f;
+    glm::vec3 sensedObstacleDirection = glm::vec3(0.0f);
+    glm::vec3 sensedSeparation = glm::vec3(0.0f);
 
-    int trailLength = 5;
-    std::vector<glm::vec3> directions;
-    std::vector<glm::vec3> normals;
-
-
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
-    GLuint VAO, VBO, EBO;
+    float speed = 0.0f;
 
     // Colors
     float boidR, boidG, boidB;
 
-    // Ray parameters
-    float rayStepSize = 0.0001f;
-    float rayMaxLength = 0.001f;
-
     // Force coefficients
     float forceApplicationCoefficient = 0.75f;
     float speedIncreaseCoefficient = 0.002f;
@@ -81,7 +91,7 @@ private:
     float maxDetectionRange = 30.0f;
     float maxBoidSpeed = 1.0f;
 
-    glm::vec3 direction;
+    glm::vec3 direction = glm::vec3(0.0f);
     glm::vec3 position;
 
 };
@@ -2,10 +2,13 @@
 #define BOX_H
 
 #include <glm/glm.hpp>
-#include <GL/glew.h>
 #include <vector>
-#include "utils/m_shader.h"
+#include <algorithm>
 
+typedef enum {
+  OBSTACLE_BOX,
+  OBSTACLE_ASTEROID
+} obstacle_t;
 
 class Obstacle {
 public:
@@ -30,7 +33,15 @@ public:
 
     virtual bool contains(const glm::vec3& point) const { return false; }
 
-    virtual void draw(Shader& shader) const { };
+    // Signed distance to the surface (negative inside), defaults to the bounding box
+    virtual float signedDistance(const glm::vec3& point) const {
+        glm::vec3 center(getX(), getY(), getZ());
+        glm::vec3 halfExtent(getWidth() / 2, getHeight() / 2, getDepth() / 2);
+        glm::vec3 q = glm::abs(point - center) - halfExtent;
+        return glm::length(glm::max(q, 0.0f)) + std::min(std::max(q.x, std::max(q.y, q.z)), 0.0f);
+    }
+
+    virtual obstacle_t getKind() const { return OBSTACLE_BOX; }
     virtual glm::vec3 getPos() const { return glm::vec3(0.0f); };
 };
 
@@ -47,10 +58,8 @@ public:
         float r_,
         float g_,
         float b_);
-    void draw(Shader& shader) const override;
-    void buildVertices();
     void setPosition(float xPos, float yPos, float zPos);
-    void rebuildVertices();
+    glm::vec3 getColor() const { return glm::vec3(r, g, b); };
     float getMinX() const override {
         return x - width / 2;
     }
@@ -78,6 +87,7 @@ public:
     float getX() const override { return x; }
     float getY() const override { return y; }
     float getZ() const override { return z; }
+    glm::vec3 getPos() const override { return glm::vec3(x, y, z); }
     float getWidth() const override { return width; }
     float getHeight() const override { return height; }
     float getDepth() const override { return depth; }
@@ -97,9 +107,6 @@ private:
     float height;
     float x, y, z;
     float r, g, b;
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
-    GLuint VAO, VBO, EBO;
 };
 
 #endif
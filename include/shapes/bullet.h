@@ -4,30 +4,30 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <tuple>
-#include "shapes/sphere.h"
 #include "shapes/boid.h"
 #include <tuple>
 #include <unordered_map>
-#include <glm/gtc/type_ptr.hpp>
 
 class Bullet {
 public:
     Bullet(glm::vec3 startPos, glm::vec3 cameraFront,
             std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>>& boid_map, int shotRange, float shotAccuracy);
 
-    
-
-    // Function to draw the bullet
-    void draw(Shader& shader);
+    // Fades the trail out, the bullet is gone once it is fully faded
+    void update();
 
     glm::vec3 getPos() const { return position; };
+    const std::vector<glm::vec3>& getTrail() const { return trail; };
 
     // Bullet sphere
     bool gone = false;
     float colorFade = 1.0f;
     
 private:
-    void drawLine(glm::vec3 start, glm::vec3 end);
+    // Snapshots restore bullets field by field, see utils/snapshot.h
+    friend struct SnapshotAccess;
+    Bullet() = default;
+
     std::tuple<int, int, int> positionToCell(const glm::vec3& pos);
     glm::vec3 position;  // Bullet position
     glm::vec3 direction; // Direction of the bullet (camera front)
@@ -2,10 +2,8 @@
 #define COLLECTIBLE_H
 
 #include <glm/glm.hpp>
-#include <GL/glew.h>
 #include <vector>
 #include <unordered_map>
-#include "utils/m_shader.h"
 
 typedef enum {
   SPEED,
@@ -16,23 +14,19 @@ typedef enum {
 
 class Collectible {
 public:
-    Collectible(float radius, glm::vec3 start_pos);
-    void draw(Shader& shader);
+    Collectible(float radius, glm::vec3 start_pos, benefit_t benefit_);
+    // Ages the collectible, it disappears after max_life frames
+    void update();
     bool contains(glm::vec3 point) const { return glm::distance(glm::vec3(x,y,z), point) < 1.1f; };
     glm::vec3 getPos() const { return glm::vec3(x,y,z); };
+    float getRadius() const { return radius; };
+    glm::vec3 getBenefitColor() const;
+    benefit_t getBenefit() const { return benefit; };
     mutable bool gone = false;
     benefit_t collect();
 
 private:
-    void buildVertices();
-    glm::vec3 getBenefitColor(benefit_t benefit);
-
     float radius;
-    int sectorCount;
-    int stackCount;
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
-    GLuint VAO, VBO, EBO;
     float x;
     float y;
     float z;
@@ -43,5 +37,5 @@ private:
 
 };
 
-#endif // SPHERE_H
+#endif // COLLECTIBLE_H
 
@@ -2,17 +2,12 @@
 #define PLAYER_H
 
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <GL/glew.h>
 #include <vector>
 #include <cmath>
 #include <unordered_map>
 
 #include "shapes/box.h"
 #include "shapes/boid.h"
-#include "utils/m_shader.h"
-#include "shapes/sphere.h"
-#include "shapes/cylinder.h"
 #include "shapes/bullet.h"
 #include <tuple>
 #include <unordered_map>
@@ -22,16 +17,24 @@ class Player {
 public:
     Player(float size, glm::vec3 start_pos);
 
-    void draw(
-      std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>>& boid_map,
-      Shader& shader, int frames_since_shot, int shot_cooldown);
     glm::vec3 getPos() const { return position; };
+    glm::vec3 getDirection() const { return direction; };
+    glm::vec3 getAimerPos() const { return aimerPos; };
+    float getSize() const { return size; };
+    const std::vector<Bullet>& getBullets() const { return bullets; };
+
     void updatePos(glm::vec3 cameraFront);
+    // Fades bullets and drops the ones that are gone
+    void updateBullets();
     void setSpeed(float s) {speed = s; };
     void applyForce(glm::vec3 force_direction, float strength);
     void applyBenefit(benefit_t collected_benefit);
 
+    // Shoots if the cooldown has passed, call once per frame. Returns whether it fired
+    bool requestShot(bool shooting, std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>>& boid_map);
     void shoot(std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>>& boid_map);
+    int getFramesSinceShot() const { return frames_since_shot; };
+    int getShotCooldown() const { return shot_cooldown; };
 
     void requestOrbit(glm::vec3 planetPos, float orbitThreshold);
 
@@ -40,29 +43,21 @@ public:
 
 
 private:
-    void buildVertices();
-    glm::vec3 rotateVertex(const glm::vec3& vertex, const glm::vec3& direction);
-    void drawLine(glm::vec3 start, glm::vec3 end);
-
+    // Snapshots save and restore every field, see utils/snapshot.h
+    friend struct SnapshotAccess;
 
     float maxSpeed = 10.1f;
 
     float size;
     glm::vec3 position;
-    glm::mat4 modelMatrix;
     glm::vec3 direction;
     glm::vec3 force_direction;
-    std::vector<glm::vec3> directions;
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
-    GLuint VAO, VBO, EBO;
-
-    mutable Sphere thruster;
-    mutable Sphere aimer;
+    glm::vec3 aimerPos;
 
     std::vector<Bullet> bullets;
 
-    int since_last_shot = 0;
+    int frames_since_shot = 0;
+    int shot_cooldown = 50;
 
     bool isOrbiting = false;
     glm::vec3 orbitPlanetPos;
@@ -1,13 +1,12 @@
 #ifndef SPACE_H
 #define SPACE_H
 
-#include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
-#include "shapes/sphere.h"
+#include <utility>
 #include "shapes/asteroid.h"
-#include "utils/m_shader.h"
+#include "utils/random.h"
 #include <unordered_map>
 #include <tuple>
 
@@ -20,20 +19,27 @@ public:
         int numStars_,
         int numAsteroids_,
         glm::vec3 playerPosition,
-        std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle*>>& box_map);
+        std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle*>>& box_map,
+        uint64_t seed);
 
-    // Function to render the sphere
-    void render(Shader& lightShader, Shader& textureShader);
+    // Background star positions, the renderer draws a small sphere at each
+    const std::vector<glm::vec3>& getStars() const { return stars; };
+    // Replaces every star, for stars streamed in with the world chunks
+    void setStars(std::vector<glm::vec3> stars_) { stars = std::move(stars_); version++; };
+    // Bumped whenever the stars change so the renderer knows to rebuild them
+    unsigned long getVersion() const { return version; };
 
 private:
 
-    glm::vec3 randomStarPos(const glm::vec3& playerPosition, float minDistance, float maxDistance);
-    glm::vec3 randomAsteroidPos(const glm::vec3& playerPosition, float minDistance, float maxDistance); std::vector<Sphere> stars;
+    glm::vec3 randomStarPos(const glm::vec3& playerPosition, float minDistance, float maxDistance, Rng& rng);
+    glm::vec3 randomAsteroidPos(const glm::vec3& playerPosition, float minDistance, float maxDistance, Rng& rng);
+    std::vector<glm::vec3> stars;
     std::vector<Asteroid> asteroids;
     float stars_radius;
     float asteroids_radius;
     int numStars;
     int numAsteroids;
+    unsigned long version = 0;
 };
 
 #endif
@@ -0,0 +1,94 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/mapped_file.h"
+
+// Every asset in one file, mapped once: textures, shaders, sounds and models
+// are read straight out of the mapping, no open or read per asset and no
+// copy. Names are paths relative to the source tree ("assets/sun.jpg"), so
+// loaders keep the paths they always used and fall back to the file system
+// for anything not packed.
+//
+// File: AssetArchiveHeader, the entries sorted by name, the names, then the
+// data, every entry ASSET_ALIGNMENT aligned. Each entry carries an FNV-1a
+// hash of its bytes, checked by verify() rather than on every open.
+
+#define ASSET_ARCHIVE_MAGIC 0x4B415042u    // "BPAK"
+#define ASSET_ARCHIVE_VERSION 1
+#define ASSET_ALIGNMENT 64                  // a cache line, also fine for GPU uploads
+
+struct AssetArchiveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t names_size;
+    uint64_t file_size;
+};
+
+struct AssetEntry {
+    uint32_t name_offset;       // into the names, after the entries
+    uint32_t name_length;
+    uint64_t offset;            // from the start of the file
+    uint64_t size;
+    uint64_t hash;              // FNV-1a of the bytes
+};
+
+// Bytes of one asset, data is nullptr when there is no such asset
+struct AssetView {
+    const char* data = nullptr;
+    size_t size = 0;
+    uint64_t hash = 0;
+
+    explicit operator bool() const { return data != nullptr; };
+};
+
+class AssetArchive {
+public:
+    // Maps the file and checks the header and table of contents, false with
+    // getError() set when it is missing or damaged
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); };
+    const std::string& getError() const { return error; };
+
+    AssetView find(std::string_view name) const;
+
+    uint32_t count() const { return header ? header->entry_count : 0; };
+    std::string_view name(uint32_t i) const;
+
+    // Hashes every entry, false with the first bad one in error
+    bool verify(std::string& error) const;
+
+private:
+    MappedFile file;
+    const AssetArchiveHeader* header = nullptr;
+    const AssetEntry* entries = nullptr;
+    const char* names = nullptr;
+    std::string error;
+};
+
+uint64_t assetHash(const char* data, size_t size);
+
+// Packs root/name for every name, false with error set when a file can't be
+// read or the archive can't be written
+bool writeAssetArchive(const std::string& path, const std::string& root, std::vector<std::string> names,
+    std::string& error);
+
+// The archive every loader looks in first, opened once at startup
+AssetArchive& assetArchive();
+
+// An asset by the path a loader uses, "../assets/sun.jpg" finds
+// "assets/sun.jpg". Empty when nothing is packed under that name.
+AssetView findAsset(std::string_view path);
+
+// From the archive, or read from disk into storage when it is not packed.
+// Empty view when neither has it.
+AssetView readAsset(const std::string& path, std::string& storage);
+
+#endif // !ASSET_ARCHIVE_H
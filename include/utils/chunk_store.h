@@ -0,0 +1,123 @@
+#ifndef CHUNK_STORE_H
+#define CHUNK_STORE_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "shapes/box.h"
+#include "algorithm/sdf.h"
+#include "utils/mapped_file.h"
+
+// A baked world on disk, split into the same chunks ChunkStreamer loads. The
+// file is mapped read only and chunks are found through a sorted index, so
+// opening it reads nothing but the header and the index, the kernel pages in
+// a chunk the first time it is used and baked bricks are used in place.
+//
+// Layout, native endian, every chunk starts 16 byte aligned:
+//   ChunkStoreHeader
+//   ChunkIndexEntry[chunk_count]       sorted by (x, y, z)
+//   per chunk: StoredAsteroid[], StoredBox[], StoredStar[], StoredBrick[]
+
+#define CHUNK_STORE_MAGIC 0x4B484342u     // "BCHK"
+#define CHUNK_STORE_VERSION 1
+
+struct ChunkStoreHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t seed;                  // seed the world was generated from
+    uint64_t file_size;
+    float chunk_size;
+    float voxel_size;               // distance field the bricks were baked for
+    float band;
+    uint32_t brick_size;
+    uint32_t chunk_count;
+    uint32_t reserved[3];
+};
+
+struct ChunkIndexEntry {
+    int32_t x, y, z;
+    uint32_t asteroid_count;
+    uint32_t box_count;
+    uint32_t star_count;
+    uint32_t brick_count;
+    uint32_t reserved;
+    uint64_t offset;                // from the start of the file
+    uint64_t bytes;
+};
+
+struct StoredAsteroid {
+    float pos[3];
+    float radius;
+    uint64_t id;                    // keys the asteroid's mesh
+};
+
+struct StoredBox {
+    float min[3];                   // axis aligned bounds
+    float max[3];
+    float color[3];
+};
+
+struct StoredStar {
+    float pos[3];
+};
+
+struct StoredBrick {
+    int32_t key[3];
+    uint32_t reserved;
+    float distances[(SDF_BRICK_SIZE + 1) * (SDF_BRICK_SIZE + 1) * (SDF_BRICK_SIZE + 1)];
+};
+
+class ChunkStore {
+public:
+    ChunkStore() = default;
+    ~ChunkStore();
+
+    ChunkStore(const ChunkStore&) = delete;
+    ChunkStore& operator=(const ChunkStore&) = delete;
+
+    // Maps the file and checks the header and index, false with getError() set
+    // when it is missing, truncated or from another version
+    bool open(const std::string& path);
+    void close();
+    // Closes a store its user can't take, getError() says why
+    void reject(const std::string& reason);
+    bool isOpen() const { return file.isOpen(); };
+    const std::string& getError() const { return error; };
+
+    const ChunkStoreHeader& getHeader() const { return *header; };
+
+    // Index entry of the chunk, nullptr when the store has nothing there
+    const ChunkIndexEntry* find(const std::tuple<int,int,int>& key) const;
+
+    // Sections of one chunk, pointing into the mapping
+    const StoredAsteroid* asteroids(const ChunkIndexEntry& entry) const;
+    const StoredBox* boxes(const ChunkIndexEntry& entry) const;
+    const StoredStar* stars(const ChunkIndexEntry& entry) const;
+    const StoredBrick* bricks(const ChunkIndexEntry& entry) const;
+
+    // Whether the bricks were baked for a field with these settings
+    bool bricksMatch(const DistanceField& field) const;
+
+private:
+    const char* section(const ChunkIndexEntry& entry, size_t skip) const;
+
+    MappedFile file;
+    const ChunkStoreHeader* header = nullptr;
+    const ChunkIndexEntry* index = nullptr;
+    std::string error;
+};
+
+// Writes obstacles, stars and the baked field, bucketed into chunks of
+// chunkSize. False with error set if the file can't be written.
+bool writeChunkStore(const std::string& path, uint64_t seed, float chunkSize,
+    const std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+    const std::vector<glm::vec3>& stars,
+    const DistanceField& field,
+    std::string& error);
+
+#endif // !CHUNK_STORE_H
@@ -0,0 +1,156 @@
+#ifndef CHUNKS_H
+#define CHUNKS_H
+
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "shapes/box.h"
+#include "algorithm/sdf.h"
+#include "utils/generation.h"
+#include "utils/chunk_store.h"
+
+// Procedural world split into cubic chunks. A chunk's boxes, asteroids and
+// stars are a pure function of (seed, chunk coordinate), so a chunk that was
+// evicted comes back identical, and only the chunks around the player have to
+// exist at any time.
+struct ChunkConfig {
+    float size = 96.0f;             // world units along each chunk edge
+    int loadRadius = 2;             // chunks kept around the player's chunk along each axis
+    int boxes = 1;                  // per chunk
+    float boxMaxSize = 1.0f;
+    int asteroids = 1;              // per chunk
+    int stars = 8;                  // per chunk
+
+    // Chunks outside the load radius stay cached, least recently used first
+    // out, until the loaded total drops under this
+    size_t budgetBytes = 32u << 20;
+
+    // Background generator threads, 0 generates on the calling thread
+    int threads = 2;
+    // Ticks from requesting a chunk to adding it. Chunks are added exactly
+    // this late, waiting for a worker if need be, so runs stay deterministic
+    // whatever the threads do.
+    int latency = 30;
+
+    // Nothing is generated this close to clearCenter (the player start)
+    glm::vec3 clearCenter = glm::vec3(0.0f);
+    float clearRadius = 10.0f;
+
+    // Baked world to read chunks from instead of generating them, see
+    // utils/chunk_store.h. Chunks it does not have are empty.
+    std::string storePath;
+};
+
+typedef std::tuple<int, int, int> chunk_key_t;
+
+struct Chunk {
+    chunk_key_t key;
+    std::vector<Obstacle*> obstacles;
+    std::vector<glm::vec3> stars;
+    std::vector<BakedBrick> bricks; // distances from the store, empty when generated
+    size_t bytes = 0;               // estimate including the distance field bricks
+    long int last_used = 0;         // tick the chunk was last inside the load radius
+};
+
+chunk_key_t positionToChunk(const glm::vec3& pos, float chunkSize);
+
+// Which chunks a streamer holds, when each was last used and when the
+// requested ones are due. Chunks are a function of their key, so this is all
+// a snapshot needs to put a streamer with the same config back in that state.
+struct ChunkStreamerState {
+    bool has_center = false;
+    chunk_key_t center;
+    std::vector<std::pair<chunk_key_t, long int>> loaded;     // key and last_used, by key
+    std::vector<std::pair<chunk_key_t, long int>> pending;    // key and due tick, by key
+};
+
+// Generates one chunk, safe to call from any thread
+Chunk generateChunk(const ChunkConfig& config, uint64_t seed, const chunk_key_t& key);
+
+// Reads one chunk out of a store, safe to call from any thread. The store has
+// to outlive the chunk's bricks.
+Chunk loadChunk(const ChunkStore& store, const chunk_key_t& key);
+
+// Keeps the chunks around the player loaded, their obstacles live in box_map
+// and the distance field like any other obstacle while loaded.
+class ChunkStreamer {
+public:
+    ChunkStreamer(const ChunkConfig& config_, uint64_t seed_);
+    // Joins the workers and frees chunks that were generated but never
+    // added. Obstacles already in box_map belong to whoever owns box_map.
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    // Requests the chunks around pos, adds the ones that are due to box_map
+    // and the field and evicts over budget. With block set every chunk in the
+    // load radius is due now. Evicted obstacles are deleted and their
+    // pointers appended to evicted. Returns true when the loaded set changed.
+    bool update(const glm::vec3& pos, long int tick, bool block,
+        std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+        DistanceField& field,
+        std::vector<const Obstacle*>& evicted);
+
+    // Stars of every loaded chunk
+    std::vector<glm::vec3> collectStars() const;
+
+    ChunkStreamerState getState() const;
+    // Evicts and loads right away until the loaded chunks are the ones in
+    // state, and requests its pending ones for the ticks they were due.
+    // Evicted obstacles are deleted and appended to evicted like update does.
+    void setState(const ChunkStreamerState& state,
+        std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+        DistanceField& field,
+        std::vector<const Obstacle*>& evicted);
+
+    size_t loadedCount() const { return loaded.size(); };
+    size_t pendingCount() const { return pending.size(); };
+    size_t loadedBytes() const { return bytes; };
+
+    // Open when config.storePath was set and could be mapped, check getError() otherwise
+    const ChunkStore& getStore() const { return store; };
+
+private:
+    void workerLoop();
+    Chunk produce(const chunk_key_t& key);
+    // Moves finished chunks into ready, optionally waiting for at least one
+    void collectDone(bool wait);
+    void add(Chunk chunk, long int tick,
+        std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+        std::vector<Obstacle*>& added,
+        std::vector<BakedBrick>& baked);
+    void evict(const chunk_key_t& key,
+        std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+        std::vector<Obstacle*>& removed);
+
+    ChunkConfig config;
+    uint64_t seed;
+    ChunkStore store;
+
+    std::unordered_map<chunk_key_t, Chunk> loaded;
+    std::unordered_map<chunk_key_t, long int> pending;   // requested, not yet added, to the tick they are due
+    std::unordered_map<chunk_key_t, Chunk> ready;        // generated, waiting to be due
+    size_t bytes = 0;
+    chunk_key_t last_center;
+    bool has_center = false;
+
+    // Shared with the workers
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::deque<chunk_key_t> jobs;
+    std::vector<Chunk> done;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+#endif // !CHUNKS_H
@@ -0,0 +1,63 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Counts of the work a frame actually does, next to the timings: when a phase
+// gets slower these say whether it is doing more work or the same work slower.
+typedef enum {
+  COUNTER_RAYCASTS,           // visibility sphere traces that missed the cache
+  COUNTER_FIELD_SAMPLES,      // DistanceField::sample calls
+  COUNTER_CONTAINS,           // Obstacle::contains tests against the player
+  COUNTER_NEIGHBOR_PAIRS,     // boid pairs evaluated by neighbor sensing
+  COUNTER_CELLS_TOUCHED,      // boid cells walked by World::step
+  COUNTER_FAR_FLOCKS,         // of those, far cells stepped as one flock
+  COUNTER_FAR_FLOCK_BOIDS,    // boids those flocks moved
+  COUNTER_BOIDS_SPAWNED,
+  COUNTER_BOIDS_KILLED,
+  COUNTER_BULLET_STEPS,       // march steps taken by bullets
+  COUNTER_CHUNKS_LOADED,      // world chunks added around the player
+  COUNTER_CHUNKS_EVICTED,
+  COUNTER_GL_UPLOADS,         // buffer uploads from the render layer
+  COUNTER_GL_CREATED,         // GL names generated: textures, buffers, VAOs, queries, programs, shaders
+  COUNTER_GL_DELETED,         // of those, deleted again, created - deleted is what is live
+  COUNTER_COUNT
+} counter_t;
+
+const char* counterName(counter_t counter);
+
+#define COUNTER_SHARDS 16       // threads beyond this share shards, still correct
+
+struct CounterSample {
+    uint64_t values[COUNTER_COUNT] = {};
+};
+
+// Per counter b - a
+CounterSample counterDelta(const CounterSample& a, const CounterSample& b);
+
+namespace counters_detail {
+// Cache line aligned so two threads never write the same line
+struct alignas(64) Shard {
+    std::atomic<uint64_t> values[COUNTER_COUNT];
+};
+extern Shard shards[COUNTER_SHARDS];
+// COUNTER_SHARDS until the thread's first event picks a shard
+extern thread_local unsigned shard;
+unsigned assignShard();
+}
+
+// A relaxed add on the calling thread's shard. Add in bulk (once per loop,
+// not per iteration) on the hottest paths.
+inline void countEvent(counter_t counter, uint64_t n = 1) {
+    unsigned s = counters_detail::shard;
+    if (s >= COUNTER_SHARDS)
+        s = counters_detail::assignShard();
+    counters_detail::shards[s].values[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+// Totals since startup summed over every shard. Take one at the start and end
+// of a frame and diff them with counterDelta.
+CounterSample countersSnapshot();
+
+#endif // !COUNTERS_H
@@ -4,21 +4,24 @@
 #include <tuple>
 #include <glm/glm.hpp>
 #include <unordered_map>
-#include <random>
+#include <cstdint>
 
 #include <functional>
 
 #include "shapes/box.h"
 #include "shapes/boid.h"
+#include "utils/random.h"
 
 namespace std {
     template<>
     struct hash<std::tuple<int, int, int>> {
+        // Packed into 63 bits and mixed, xoring shifted coordinates sent
+        // nearby cells to the same few buckets
         size_t operator()(const std::tuple<int, int, int>& t) const {
-            size_t h1 = std::hash<int>{}(std::get<0>(t));
-            size_t h2 = std::hash<int>{}(std::get<1>(t));
-            size_t h3 = std::hash<int>{}(std::get<2>(t));
-            return h1 ^ (h2 << 1) ^ (h3 << 2);
+            uint64_t x = static_cast<uint32_t>(std::get<0>(t)) & 0x1fffff;
+            uint64_t y = static_cast<uint32_t>(std::get<1>(t)) & 0x1fffff;
+            uint64_t z = static_cast<uint32_t>(std::get<2>(t)) & 0x1fffff;
+            return static_cast<size_t>(mix64(x | y << 21 | z << 42));
         }
     };
 }
@@ -26,30 +29,39 @@ namespace std {
 #define CELL_SIZE 2.0f
 
 std::tuple<int, int, int> positionToCell(const glm::vec3& pos);
-
-void drawChunkBorders(const std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle>>& box_map);
+glm::vec3 cellCenter(const std::tuple<int, int, int>& cell);
+// Distance from cellCenter to the cell's faces along each axis
+glm::vec3 cellHalfExtent(const std::tuple<int, int, int>& cell);
 
 
 
+// Rejection samples rng until the point is at least minDistance outside every box in its cell
 glm::vec3 getRandomPointOutsideObstacles(
     std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
     float maxPosition,
-    float minDistance);
+    float minDistance,
+    Rng& rng);
 
 std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>> generateRandomBoxes(
-    int numObstaclees, float maxSize, float maxPosition);
+    int numObstaclees, float maxSize, float maxPosition, uint64_t seed);
 
+// New boids take their ids from next_id, which is advanced past them
 void generateRandomBoids(
     std::unordered_map<std::tuple<int, int, int>, std::vector<Boid>>& result,
     int count,
     int maxDistance,
     std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle*>>& box_map,
-    long int frame, glm::vec3 playerPos);
+    long int frame, glm::vec3 playerPos, uint64_t seed, unsigned long& next_id);
+
+class MortonOrder;
 
+// Moves the boids that left their cell into the one they are in now, drops
+// empty cells and sorts the cells into order
 std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> recalculateCells(
-    std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> old_map, int& num_boids);
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> boid_map, int& num_boids,
+    MortonOrder& order, long int frame);
 
-bool shouldSpawnBoid(long frame);
+bool shouldSpawnBoid(long frame, uint64_t seed);
 
 
 #endif // !GENERATION_H
@@ -0,0 +1,66 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Startup work split between worker threads and the thread that owns the GL
+// context. A job's work runs on a worker (file reads, image and audio decode,
+// world generation) and its finish, if any, runs on the polling thread once
+// the work is done (texture and buffer uploads). Main jobs only ever run on
+// the polling thread, for GL work that can't be split (shader compiles).
+//
+// The polling thread keeps drawing frames between polls, so the window shows
+// progress instead of hanging until everything is in.
+class AsyncLoader {
+public:
+    explicit AsyncLoader(int threads);
+    // Waits for work already started, queued work is dropped
+    ~AsyncLoader();
+
+    AsyncLoader(const AsyncLoader&) = delete;
+    AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+    // Names must be string literals, they label profiler zones. Weight is the
+    // job's share of the progress bar, roughly its cost.
+    void add(const char* name, float weight, std::function<void()> work, std::function<void()> finish = {});
+    void addMain(const char* name, float weight, std::function<void()> work);
+
+    // Runs every finish whose work is done, then main jobs until budgetMs is
+    // used up (at least one). True once every job has finished.
+    bool poll(double budgetMs);
+
+    // Finished share of the total weight, 0..1
+    float progress();
+    // A job still in flight, for the progress screen, empty when done
+    std::string current();
+
+private:
+    struct Job {
+        const char* name;
+        float weight;
+        std::function<void()> work;
+        std::function<void()> finish;
+    };
+    void workerLoop();
+
+    std::deque<Job> main_jobs;          // polling thread only
+    float total = 0.0f;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    std::vector<Job> done;              // work done, finish still to run
+    std::vector<const char*> running;
+    float finished = 0.0f;
+    size_t outstanding = 0;             // added and not finished, both kinds
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+#endif // !LOADER_H
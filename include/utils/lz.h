@@ -0,0 +1,22 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Byte oriented LZ77 in the style of an LZ4 block: runs of literals and
+// back references up to 64 KB away, no entropy coding. Fast enough to run on
+// every save, and state full of repeated floats and zeros shrinks a lot.
+//
+// Sequence: token (literal length << 4 | match length - 4), extra literal
+// length bytes when the nibble is 15, the literals, a 2 byte little endian
+// offset, extra match length bytes. The last sequence stops after its literals.
+
+// Appends the compressed bytes to out
+void lzCompress(const uint8_t* in, size_t size, std::vector<uint8_t>& out);
+
+// Decodes into exactly outSize bytes, false on malformed or truncated input
+bool lzDecompress(const uint8_t* in, size_t size, uint8_t* out, size_t outSize);
+
+#endif // !LZ_H
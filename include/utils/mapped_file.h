@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped read only. Pages are read in on first touch and shared
+// with the page cache, so opening costs the same for 1 KB and 1 GB and the
+// data is never copied into the heap.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False with getError() set when the file is missing, empty or can't be
+    // mapped. Random tells the kernel not to read ahead.
+    bool open(const std::string& path, bool random = false);
+    void close();
+    bool isOpen() const { return base != nullptr; };
+    const std::string& getError() const { return error; };
+
+    const char* data() const { return static_cast<const char*>(base); };
+    size_t size() const { return length; };
+
+private:
+    void* base = nullptr;
+    size_t length = 0;
+    std::string error;
+};
+
+#endif // !MAPPED_FILE_H
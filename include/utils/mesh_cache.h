@@ -0,0 +1,45 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "algorithm/simplify.h"
+
+// Meshes as loadModel hands them to the renderer (interleaved position and
+// normal, triangle indices) with their chain of simplified levels, cached so
+// later runs map them instead of running Assimp, the vertex decimation and
+// the simplifier again. A file is keyed by everything that changes the
+// result: the model's content hash, the scale and the sample rate.
+//
+// File: MeshFileHeader, the vertex floats, lod_count MeshLod entries, then
+// the indices of every level, full mesh first.
+
+#define MESH_FILE_MAGIC 0x48534D42u        // "BMSH"
+#define MESH_FILE_VERSION 2
+#define MESH_CACHE_DIR "boids_mesh_cache"
+
+struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;       // assetHash of the model file
+    float scale;
+    uint32_t sample_rate;
+    uint64_t vertex_floats;     // 6 per vertex
+    uint64_t index_count;       // all levels
+    uint32_t lod_count;
+    uint32_t reserved;
+};
+
+// Appends the cached vertices and replaces indices and lods, false when there
+// is no cached copy for this key or it is damaged
+bool loadCachedMesh(const std::string& dir, uint64_t sourceHash, float scale, int sampleRate,
+    std::vector<float>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods);
+
+// Caches a mesh for the key, false when it can't be written
+bool storeCachedMesh(const std::string& dir, uint64_t sourceHash, float scale, int sampleRate,
+    const float* vertices, size_t vertexFloats, const std::vector<uint32_t>& indices,
+    const std::vector<MeshLod>& lods);
+
+#endif // !MESH_CACHE_H
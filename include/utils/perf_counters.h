@@ -0,0 +1,58 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+// Hardware counters for the calling thread through Linux perf_event_open,
+// opened as one group so every read is a consistent snapshot. Anywhere else,
+// or when the kernel says no (perf_event_paranoid, containers, VMs without a
+// PMU), open() fails with a reason and reads return zeros.
+typedef enum {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_COUNTER_COUNT
+} perf_counter_t;
+
+const char* perfCounterName(perf_counter_t counter);
+
+struct PerfSample {
+    uint64_t values[PERF_COUNTER_COUNT] = {};
+};
+
+// Per counter b - a, zero where either side is missing
+PerfSample perfDelta(const PerfSample& a, const PerfSample& b);
+
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Counts user space on this thread only. Individual counters the CPU
+    // lacks are skipped, false only when none could be opened.
+    bool open();
+    void close();
+
+    bool isOpen() const { return leader >= 0; };
+    bool available(perf_counter_t counter) const { return slots[counter] >= 0; };
+    const std::string& getError() const { return error; };
+
+    // One syscall, roughly a microsecond, so read per phase rather than per zone.
+    // When the kernel multiplexed the group onto the PMU part of the time the
+    // values are scaled up by enabled / running time, estimates rather than counts.
+    PerfSample read() const;
+
+private:
+    int fds[PERF_COUNTER_COUNT] = {-1, -1, -1, -1};
+    int slots[PERF_COUNTER_COUNT] = {-1, -1, -1, -1};   // position in the group read
+    int opened = 0;
+    int leader = -1;
+    std::string error;
+};
+
+#endif // !PERF_COUNTERS_H
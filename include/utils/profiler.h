@@ -0,0 +1,133 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#define PROFILER_TSC
+#endif
+
+// Scoped CPU zones for frame profiling. Every thread writes its finished zones
+// into its own ring buffer, nothing is shared on the hot path, and the rings
+// can be dumped as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+//
+//   void World::step(...) {
+//       PROFILE_ZONE("World::step");
+//       ...
+//   }
+//
+// Zone names must be string literals, only the pointer is stored. Build with
+// -DBOIDS_NO_PROFILER to compile every zone out.
+//
+// An enabled zone costs two clock reads and one ring write. On x86-64 the clock
+// is the invariant TSC scaled to nanoseconds: the ProfileZone bench measured
+// 40-48 ns per zone on a Xeon VM, where rdtsc alone is about 21 ns, against
+// 71-89 ns with two steady_clock reads. The scale is calibrated over 1 ms and
+// good to about 1e-4, every timestamp uses it so zones agree with each other.
+// CLOCK_MONOTONIC_COARSE is cheaper but only ticks every 4 ms there.
+
+#define PROFILER_RING_SIZE (1 << 16)     // zones kept per thread, a power of two
+#define PROFILER_CALIBRATION_NS 1000000  // TSC rate measured against the steady clock over this long at startup
+
+typedef enum {
+  PROFILE_EVENT_ZONE,
+  PROFILE_EVENT_COUNTER
+} profile_event_t;
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;    // for counters, the value at start_ns
+    uint32_t depth;     // nesting level on its thread, 0 for outermost zones
+    uint32_t kind;      // profile_event_t
+};
+
+namespace profiler_detail {
+extern std::atomic<bool> enabled;
+extern thread_local uint32_t depth;
+
+// TSC ticks to steady clock nanoseconds, measured once during static init
+struct TscClock {
+    bool usable;        // false without an invariant TSC, or before calibration
+    uint64_t base_tsc;
+    uint64_t base_ns;
+    uint64_t mult;      // nanoseconds per tick, 32.32 fixed point
+};
+extern const TscClock tsc;
+uint64_t steadyNow();
+}
+
+// Nanoseconds on the steady clock time line, read from the TSC where it is
+// invariant. The time base for every event.
+inline uint64_t profilerNow() {
+#ifdef PROFILER_TSC
+    const profiler_detail::TscClock& clock = profiler_detail::tsc;
+    if (clock.usable) {
+        unsigned __int128 ticks = __rdtsc() - clock.base_tsc;
+        return clock.base_ns + static_cast<uint64_t>((ticks * clock.mult) >> 32);
+    }
+#endif
+    return profiler_detail::steadyNow();
+}
+
+// Zones are recorded while enabled, a disabled zone costs one relaxed load
+void profilerSetEnabled(bool enabled);
+bool profilerEnabled();
+
+// Name shown for the calling thread in the trace
+void profilerSetThreadName(const char* name);
+
+// Records a zone that was timed by hand, for phases that do not map to a scope
+void profilerRecord(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+// Records a counter value, shown as a graph above the thread tracks
+void profilerCounter(const char* name, uint64_t ts_ns, uint64_t value);
+
+// Copies the zones currently held by every thread, oldest first per thread
+struct ProfileThread {
+    std::string name;
+    uint32_t id;
+    std::vector<ProfileEvent> events;
+};
+std::vector<ProfileThread> profilerSnapshot();
+
+// Writes every held zone as Chrome trace JSON, false if the file can't be written
+bool writeChromeTrace(const std::string& path);
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name_) : name(name_), start(0) {
+        if (profiler_detail::enabled.load(std::memory_order_relaxed)) {
+            start = profilerNow();
+            profiler_detail::depth++;
+        }
+    }
+    ~ProfileZone() {
+        if (start != 0) {
+            profiler_detail::depth--;
+            profilerRecord(name, start, profilerNow());
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifndef BOIDS_NO_PROFILER
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+
+#endif // !PROFILER_H
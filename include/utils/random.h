@@ -0,0 +1,56 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Independent streams drawn from the world seed, one per kind of generated thing
+typedef enum {
+  RNG_BOXES,
+  RNG_BOID_SPAWN,
+  RNG_BOID_COLOR,
+  RNG_SPAWN_CHANCE,
+  RNG_STARS,
+  RNG_ASTEROIDS,
+  RNG_ASTEROID_MESH,
+  RNG_DROPS,
+  RNG_CHUNK_BOXES,
+  RNG_CHUNK_ASTEROIDS,
+  RNG_CHUNK_STARS
+} rng_stream_t;
+
+// SplitMix64 finalizer, a good 64 bit mixer on its own
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Counter-based generator: the n-th draw is a pure function of
+// (seed, stream, key, tick, n). Construct one wherever randomness is needed,
+// keyed by entity id and tick, instead of sharing a generator, so results do
+// not depend on call order or on which thread asks. 16 bytes, no setup cost.
+class Rng {
+public:
+    Rng(uint64_t seed, rng_stream_t stream, uint64_t key = 0, uint64_t tick = 0)
+        : base(mix64(mix64(mix64(seed ^ (uint64_t(stream) << 56)) ^ key) ^ tick)) {}
+
+    uint64_t next() { return mix64(base + 0x9E3779B97F4A7C15ULL * counter++); }
+
+    // [0, 1) with 24 bits, exact in a float
+    float uniform() { return (next() >> 40) * (1.0f / 16777216.0f); }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+
+    // [lo, hi] inclusive
+    int range(int lo, int hi) {
+        return lo + static_cast<int>((next() >> 32) * (uint64_t(hi - lo) + 1) >> 32);
+    }
+
+    bool chance(float p) { return uniform() < p; }
+
+private:
+    uint64_t base;
+    uint64_t counter = 0;
+};
+
+#endif // !RANDOM_H
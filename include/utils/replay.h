@@ -0,0 +1,97 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/world.h"
+
+// Recorded PlayerInput, one per World::step. With the seed, the world
+// config flags and the baked world it was played on that is everything a run
+// depends on, so replaying a session steps through exactly the same states,
+// headless or in the window. The final World::checksum() is kept to prove it.
+//
+// File: ReplayHeader, then one record per tick. A record is a mask byte of
+// what changed since the previous tick followed by only those fields: the
+// keys as a 16 bit set, then yaw, pitch, radius and deltaTime as raw floats.
+// A zero mask is followed by a varint count of further unchanged ticks, so
+// holding a key down or idling costs a couple of bytes however long it lasts.
+
+#define REPLAY_MAGIC 0x4C505242u         // "BRPL"
+#define REPLAY_VERSION 2
+#define REPLAY_STREAMING 1u
+#define REPLAY_CHECKSUM 2u
+
+struct ReplayHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;             // REPLAY_STREAMING when the world was streamed, REPLAY_CHECKSUM when checksum is set
+    uint32_t reserved;
+    uint64_t seed;
+    uint64_t tick_count;
+    uint64_t store_hash;        // chunkStoreHash() of the baked world played on, 0 for none
+    uint64_t checksum;          // World::checksum() after the last tick
+};
+
+// FNV-1a of a chunk store's header (seed, chunk and brick settings, file
+// size), 0 when path is empty or does not open as a store
+uint64_t chunkStoreHash(const std::string& path);
+
+// Collects inputs in memory, the file is written on close
+class ReplayRecorder {
+public:
+    // Writes whatever was recorded if close was not called
+    ~ReplayRecorder();
+
+    void open(const std::string& path_, const WorldConfig& config);
+    bool isOpen() const { return !path.empty(); };
+    void record(const PlayerInput& input);
+    // False with the reason in getError() when the file can't be written
+    bool close();
+    // Same, storing World::checksum() as of after the last recorded tick
+    bool close(uint64_t checksum);
+
+    uint64_t getTickCount() const { return header.tick_count; };
+    size_t getByteCount() const { return data.size(); };
+    const std::string& getError() const { return error; };
+
+private:
+    void flushRun();
+
+    std::string path;
+    ReplayHeader header = {};
+    std::vector<uint8_t> data;
+    PlayerInput last;
+    uint64_t run = 0;           // unchanged ticks not written yet
+    std::string error;
+};
+
+// Decodes a whole replay up front, a few bytes per tick
+class ReplayReader {
+public:
+    // False with the reason in getError() when the file is missing or damaged
+    bool open(const std::string& path);
+
+    const std::vector<PlayerInput>& getInputs() const { return inputs; };
+    uint64_t getSeed() const { return header.seed; };
+    bool getStreaming() const { return header.flags & REPLAY_STREAMING; };
+    const std::string& getError() const { return error; };
+
+    // Seed and streaming as recorded, on top of config
+    void apply(WorldConfig& config) const;
+    // False with the reason in getError() when config plays another baked
+    // world (or none) than the session was recorded on
+    bool checkStore(const WorldConfig& config);
+    // False with the reason in getError() when world, having stepped through
+    // every input, is not where the recorded session ended. Recordings
+    // closed without a world have nothing to check and pass.
+    bool checkEnd(const World& world);
+
+private:
+    ReplayHeader header = {};
+    std::vector<PlayerInput> inputs;
+    std::string error;
+};
+
+#endif // !REPLAY_H
@@ -0,0 +1,39 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "utils/world.h"
+
+// Where the scripted player should be at a tick, positions in between are interpolated
+struct PathPoint {
+    long int tick;
+    glm::vec3 position;
+};
+
+// A reproducible headless run: world setup, spawn curve and scripted player.
+// Loaded from a key = value file, see scenarios/README.md for the keys.
+struct Scenario {
+    std::string name;
+    unsigned int seed = 1;
+    long int ticks = 1000;
+    float deltaTime = 1.0f / 60.0f;
+
+    WorldConfig world;
+
+    std::vector<PathPoint> path;
+    int shootEvery = 0;           // Fire every N ticks, 0 never shoots
+
+    std::string checksum;         // Expected final World::checksum in hex, empty skips the check
+};
+
+// Returns false and prints the offending line to stderr on a malformed file
+bool loadScenario(const std::string& path, Scenario& scenario);
+
+// Steers the player toward the path position for this tick through the same
+// PlayerInput the window layer produces
+PlayerInput scriptedInput(const Scenario& scenario, const World& world, long int tick);
+
+#endif // !SCENARIO_H
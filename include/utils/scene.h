@@ -11,11 +11,12 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 #include <thread>
-#include "shapes/player.h"
 #include <tuple>
 #include <unordered_map>
-#include "shapes/boid.h"
-#include "utils/generation.h"
+#include <vector>
+#include "utils/world.h"
+#include "utils/texture_cache.h"
+#include "utils/asset_archive.h"
 
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -37,11 +38,7 @@ float fov   =  45.0f;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-float cameraSpeed = 5.5f;
 float radius = 5.0f;  // Radius of orbit around the player
-                      //
-int frames_since_shot = 0;
-int shot_cooldown = 50;
 
 void updateCameraPositionAroundPlayer(glm::vec3 playerPos, float radius, float yaw, float pitch, glm::vec3& cameraPos, glm::vec3& cameraFront) {
     // Convert spherical coordinates to Cartesian coordinates for camera position
@@ -89,33 +86,28 @@ void updateCamera(GLFWwindow* window, glm::vec3 playerPos) {
     updateCameraPositionAroundPlayer(playerPos, radius, yaw, pitch, cameraPos, cameraFront);
 }
 
-void processInput(GLFWwindow *window, Player& player, 
-    std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>>& boid_map) {
-    cameraSpeed = 2.5f * deltaTime;
-
-    if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS)
-        cameraSpeed = 10.5f * deltaTime;
-
-    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS)
-        player.speed = 0.0f;
-
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        player.applyForce(cameraFront, cameraSpeed);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        player.applyForce(-cameraFront, cameraSpeed);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        player.applyForce(-glm::normalize(glm::cross(cameraFront, cameraUp)), cameraSpeed);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        player.applyForce(glm::normalize(glm::cross(cameraFront, cameraUp)), cameraSpeed);
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
-        player.applyForce(cameraUp, cameraSpeed);
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
-        player.applyForce(-cameraUp, cameraSpeed);
-    if (glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS && frames_since_shot >= shot_cooldown){
-        player.shoot(boid_map);
-        frames_since_shot = 0;
-    }
-    frames_since_shot++;
+// True only on the frame the key goes down, for toggles that must not repeat
+bool keyPressed(GLFWwindow* window, int key) {
+    static std::unordered_map<int, bool> held;
+    bool down = glfwGetKey(window, key) == GLFW_PRESS;
+    bool pressed = down && !held[key];
+    held[key] = down;
+    return pressed;
+}
+
+// Reads the keyboard into a PlayerInput, the arrow keys and zoom only move the camera
+PlayerInput processInput(GLFWwindow *window) {
+    PlayerInput input;
+    input.deltaTime = deltaTime;
+    input.boost = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS;
+    input.stop = glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS;
+    input.forward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    input.back = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    input.left = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    input.right = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    input.up = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+    input.down = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
+    input.shoot = glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
 
     float sensitivity = 2.5f;
 
@@ -140,6 +132,11 @@ void processInput(GLFWwindow *window, Player& player,
         radius += zoom_rate;
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
         radius -= zoom_rate;
+
+    input.yaw = yaw;
+    input.pitch = pitch;
+    input.radius = radius;
+    return input;
 }
 
 
@@ -238,29 +235,74 @@ std::optional<GLFWwindow*> init_scene(){
     return std::optional(window);
 }
 
-GLuint loadTexture(const char* path) {
+#define TEXTURE_CACHE_DIR "boids_texture_cache"
+
+// stb_image decoding for the texture cache, rows bottom up as GL wants them.
+// No GL, safe on any thread.
+bool decodeImage(const char* path, std::vector<uint8_t>& pixels, int& width, int& height, int& channels) {
+    // Thread local, the global flag would race with other decoding threads
+    stbi_set_flip_vertically_on_load_thread(true);  // Flip texture vertically
+    AssetView packed = findAsset(path);
+    unsigned char* data = packed
+        ? stbi_load_from_memory(reinterpret_cast<const unsigned char*>(packed.data), packed.size, &width, &height, &channels, 0)
+        : stbi_load(path, &width, &height, &channels, 0);
+    if (!data) {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return false;
+    }
+    pixels.assign(data, data + size_t(width) * height * channels);
+    stbi_image_free(data);
+    return true;
+}
+
+// Baked copy of the image from the texture cache, baked first when it is
+// missing or older than the image. No GL, safe on any thread.
+bool openTexture(const char* path, TextureFile& texture) {
+    bool compress = GLEW_EXT_texture_compression_s3tc;
+    return openCachedTexture(TEXTURE_CACHE_DIR, path, compress, decodeImage, texture);
+}
+
+// Needs the GL context, uploads every baked level as it is. A texture that
+// failed to open gives an empty texture.
+GLuint uploadTexture(const TextureFile& texture) {
     GLuint textureID;
     glGenTextures(1, &textureID);
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true);  // Flip texture vertically
-    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data) {
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        if (nrChannels == 3)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        else if (nrChannels == 4)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        stbi_image_free(data);
-    } else {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+    countEvent(COUNTER_GL_CREATED);
+    if (!texture.isOpen())
+        return textureID;
+    const TextureFileHeader& header = texture.getHeader();
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.levels - 1);
+    // Baked rows are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; i < header.levels; i++) {
+        const TextureLevel& level = header.level[i];
+        const uint8_t* data = texture.levelData(i);
+        switch (texture.getFormat()) {
+            case TEXTURE_BC1:
+                glCompressedTexImage2D(GL_TEXTURE_2D, i, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                    level.width, level.height, 0, level.bytes, data);
+                break;
+            case TEXTURE_RGBA8:
+                glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+                break;
+            default:
+                glTexImage2D(GL_TEXTURE_2D, i, GL_RGB, level.width, level.height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+                break;
+        }
     }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     return textureID;
 }
 
+GLuint loadTexture(const char* path) {
+    TextureFile texture;
+    openTexture(path, texture);
+    return uploadTexture(texture);
+}
+
 #endif
@@ -0,0 +1,150 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "utils/world.h"
+
+// Checkpoints of a running World: boids, bullets, collectibles, the player,
+// planet orbits, the frame and the boid id counter. With the seed that is
+// every input the counter-based Rng has, so a restored world carries on
+// exactly like the one that was saved. Obstacles and stars are not stored,
+// they come back from the seed (or the chunk store) with the WorldConfig. A
+// streaming world stores which chunks were loaded and pending, the restore
+// loads and evicts chunks to match.
+//
+// File: SnapshotHeader, then the payload, LZ compressed when flagged. The
+// payload hash and the world checksum are checked on restore.
+
+#define SNAPSHOT_MAGIC 0x504E5342u        // "BSNP"
+#define SNAPSHOT_VERSION 3
+#define SNAPSHOT_COMPRESSED 1u
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t layout;            // sizes of the structs stored as raw bytes, a snapshot only loads into the same build
+    uint64_t raw_size;
+    uint64_t stored_size;
+    uint64_t payload_hash;      // FNV-1a of the uncompressed payload
+    uint64_t world_checksum;    // World::checksum() when saved
+    uint64_t seed;
+    int64_t frame;
+};
+
+// Appends plain values to a byte buffer
+class SnapshotOut {
+public:
+    SnapshotOut(std::vector<uint8_t>& buffer_) : buffer(buffer_) {}
+
+    void bytes(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        buffer.insert(buffer.end(), p, p + size);
+    }
+    template<typename T> void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are written as bytes");
+        bytes(&value, sizeof(T));
+    }
+
+private:
+    std::vector<uint8_t>& buffer;
+};
+
+// Reads them back, every read after running off the end fails
+class SnapshotIn {
+public:
+    SnapshotIn(const uint8_t* data, size_t size) : p(data), end(data + size) {}
+
+    bool bytes(void* data, size_t size) {
+        if (!ok || size > size_t(end - p))
+            return ok = false;
+        std::memcpy(data, p, size);
+        p += size;
+        return true;
+    }
+    template<typename T> bool get(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are read as bytes");
+        return bytes(&value, sizeof(T));
+    }
+    bool good() const { return ok; };
+    bool atEnd() const { return p == end; };
+
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+};
+
+// Friend of the classes with private state, reads and writes every field
+struct SnapshotAccess {
+    static void writePlayer(SnapshotOut& out, const Player& player);
+    static bool readPlayer(SnapshotIn& in, Player& player);
+};
+
+// The payload for the world as it is now
+std::vector<uint8_t> serializeWorld(const World& world);
+
+// Header fields that need the world (checksum, seed, frame), taken with the payload
+SnapshotHeader snapshotHeader(const World& world);
+
+// The file: header with sizes and hash filled in, then the payload, compressed when asked
+std::vector<uint8_t> encodeSnapshot(SnapshotHeader header, const std::vector<uint8_t>& payload, bool compress);
+
+// Synchronous save, false with error set if the file can't be written
+bool saveSnapshot(const World& world, const std::string& path, bool compress, std::string& error);
+
+// Replaces the dynamic state of world, which has to be built from the config
+// the snapshot was saved with. False with error set when the file is damaged or
+// from another build or seed, the world is left untouched then. Also false when
+// the restored state does not hash the same, but that is found after the world
+// was replaced, so it holds the mismatched state.
+// Obstacles a streaming restore evicts are added to world.evicted_obstacles.
+bool restoreSnapshot(World& world, const std::string& path, std::string& error);
+
+// Saves without stalling the caller: save() copies the state (about a memcpy
+// of the boids), compression and the file write run on a background thread.
+class SnapshotSaver {
+public:
+    SnapshotSaver();
+    // Finishes every queued save first
+    ~SnapshotSaver();
+
+    SnapshotSaver(const SnapshotSaver&) = delete;
+    SnapshotSaver& operator=(const SnapshotSaver&) = delete;
+
+    void save(const World& world, const std::string& path, bool compress = true);
+
+    // Blocks until the queue is empty, false if any save since the last call failed
+    bool wait();
+    std::string getError();
+
+private:
+    struct Job {
+        std::string path;
+        std::vector<uint8_t> payload;
+        SnapshotHeader header;
+        bool compress;
+    };
+    void workerLoop();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Job> jobs;
+    bool busy = false;
+    bool stopping = false;
+    bool failed = false;
+    std::string error;
+    std::thread worker;
+};
+
+#endif // !SNAPSHOT_H
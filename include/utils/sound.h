@@ -5,6 +5,7 @@
 #include <SDL2/SDL_mixer.h>
 #include <vector>
 #include <iostream>
+#include "utils/asset_archive.h"
 
 std::vector<Mix_Chunk*> sounds;
 std::vector<Mix_Music*> music;
@@ -23,7 +24,12 @@ int loadMusic(const char* filename) {
 }
 int loadSound(const char* filename) {
 	Mix_Chunk *m = NULL;
-	m = Mix_LoadWAV(filename);
+	// Decoded straight out of the asset archive mapping when packed
+	AssetView packed = findAsset(filename);
+	if(packed)
+		m = Mix_LoadWAV_RW(SDL_RWFromConstMem(packed.data, packed.size), 1);
+	else
+		m = Mix_LoadWAV(filename);
 	if(m == NULL) {
 		printf("Failed to load music. SDL_Mixer error: %s\n", Mix_GetError());
 		return -1;
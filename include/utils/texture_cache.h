@@ -0,0 +1,89 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/mapped_file.h"
+
+// GPU ready textures: every mip level baked on the CPU, BC1 (DXT1) block
+// compressed for opaque images when the driver takes it, in a file that is
+// mapped and handed to glTexImage2D level by level. Decoding JPEG/PNG and
+// building mips happens once, on the first run after the image changes.
+//
+// File: TextureFileHeader, TEXTURE_MAX_LEVELS level entries, then the levels
+// from largest to smallest, each 16 byte aligned.
+
+#define TEXTURE_FILE_MAGIC 0x58544542u     // "BETX"
+#define TEXTURE_FILE_VERSION 1
+#define TEXTURE_MAX_LEVELS 16
+
+typedef enum {
+  TEXTURE_RGB8,
+  TEXTURE_RGBA8,
+  TEXTURE_BC1,          // 8 bytes per 4x4 block, RGB only
+  TEXTURE_FORMAT_COUNT
+} texture_format_t;
+
+const char* textureFormatName(texture_format_t format);
+
+struct TextureLevel {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;        // from the start of the file
+    uint64_t bytes;
+};
+
+struct TextureFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;        // texture_format_t
+    uint32_t levels;
+    uint64_t source_size;   // the image it was baked from, a changed image is rebaked
+    int64_t source_mtime;   // content hash for images from the asset archive
+    TextureLevel level[TEXTURE_MAX_LEVELS];
+};
+
+// Bakes decoded 8 bit pixels (3 or 4 channels, rows bottom up as GL wants
+// them) into a texture file. Compress picks BC1 for 3 channel images.
+std::vector<uint8_t> bakeTexture(const uint8_t* pixels, int width, int height, int channels, bool compress,
+    uint64_t sourceSize, int64_t sourceMtime);
+
+// A baked texture, mapped from the cache or held in memory
+class TextureFile {
+public:
+    // False with getError() set when the file is missing, damaged or stale
+    bool open(const std::string& path);
+    // Takes a freshly baked texture, for when the cache can't be written
+    bool adopt(std::vector<uint8_t> data);
+    void close();
+    bool isOpen() const { return header != nullptr; };
+    const std::string& getError() const { return error; };
+
+    const TextureFileHeader& getHeader() const { return *header; };
+    texture_format_t getFormat() const { return static_cast<texture_format_t>(header->format); };
+    const uint8_t* levelData(uint32_t level) const { return base + header->level[level].offset; };
+    // GPU memory of all levels, the file minus its header
+    size_t gpuBytes() const;
+
+private:
+    bool validate(size_t size);
+
+    MappedFile file;
+    std::vector<uint8_t> memory;
+    const uint8_t* base = nullptr;
+    const TextureFileHeader* header = nullptr;
+    std::string error;
+};
+
+// Cached texture for an image file, or the packed image of that name in the
+// asset archive: opens the baked copy in dir when it was baked from the image
+// as it is now, otherwise bakes it with decode and writes it there.
+// decode fills pixels bottom up, false when the image can't be read. Safe on
+// any thread, no GL.
+typedef bool (*texture_decoder_t)(const char* path, std::vector<uint8_t>& pixels, int& width, int& height, int& channels);
+bool openCachedTexture(const std::string& dir, const std::string& imagePath, bool compress,
+    texture_decoder_t decode, TextureFile& texture);
+
+#endif // !TEXTURE_CACHE_H
@@ -1,27 +1,82 @@
-#include <iostream>
+#ifndef TIMER_H
+#define TIMER_H
+
 #include <chrono>
-#include <iomanip>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define STATS_HISTOGRAM_BUCKETS 64     // quarter octaves from 0.1 ms, the last one is open ended
+
+struct StatsSummary {
+    double p50, p95, p99, max, mean;
+};
+
+struct Hitch {
+    long frame;
+    double ms;
+};
+
+// Rolling window of per-frame durations in milliseconds plus lifetime
+// histogram and hitch log. Percentiles only look at the last `window` samples
+// so a slow start does not hide in the average forever.
+class FrameStats {
+public:
+    FrameStats(size_t window_ = 1000, double hitchMs_ = 50.0);
+
+    void add(double ms);
+
+    // One sort of the window, call once per report rather than per percentile
+    StatsSummary summary() const;
+
+    long getCount() const { return count; };
+    // Samples still in the window, recent(0) is the newest
+    size_t size() const { return samples.size(); };
+    double recent(size_t age) const { return samples[(next + window - 1 - age) % window]; };
+    long getHitchCount() const { return hitch_count; };
+    double getHitchThreshold() const { return hitchMs; };
+    const std::vector<Hitch>& getHitches() const { return hitches; };
+    const long* getHistogram() const { return histogram; };
+
+    // Bucket b holds samples in [bucketLower(b), bucketLower(b + 1))
+    static double bucketLower(int bucket);
+
+    // Histogram as lower_ms,upper_ms,count rows
+    void writeCsv(std::ostream& out) const;
+    // Window summary, hitches and the non-empty histogram buckets
+    void writeJson(std::ostream& out) const;
+
+private:
+    size_t window;
+    double hitchMs;
+
+    std::vector<double> samples;    // ring of the last `window` samples
+    size_t next = 0;
+    long count = 0;
+
+    long histogram[STATS_HISTOGRAM_BUCKETS] = {};
+    long hitch_count = 0;
+    std::vector<Hitch> hitches;     // first hitches only, the count keeps going
+};
 
 class Timer {
 public:
+    Timer(double hitchMs = 50.0, size_t window = 1000);
+
     // Starts the timer by recording the start time
     void start() {
         start_time = std::chrono::high_resolution_clock::now();
     }
 
-    // Stops the timer, calculates the elapsed time, and outputs it
-    void record() {
-        num_frames++;
-        auto end_time = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end_time - start_time;
-        game_time += elapsed.count();
-        frame_rate = game_time / num_frames;
-        std::cout << std::fixed << std::setprecision(2);
-        std::cout << "\rFrame Rate: " << 1.0f / frame_rate << " FPS    " << std::flush;
-        start_time = end_time;
-    }
+    // Stops the timer and adds the frame, prints the rolling stats about once a second
+    void record();
 
     long int get_frame() const { return num_frames; };
+    const FrameStats& getStats() const { return stats; };
+
+    bool writeCsv(const std::string& path) const;
+    bool writeJson(const std::string& path) const;
 
     double game_time = 0.0f;
     double frame_rate = 0.0f;
@@ -29,5 +84,8 @@ public:
 
 private:
     std::chrono::high_resolution_clock::time_point start_time;
+    FrameStats stats;
+    double since_report = 0.0;
 };
 
+#endif // !TIMER_H
@@ -0,0 +1,175 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include <tuple>
+#include <unordered_map>
+
+#include "shapes/player.h"
+#include "shapes/boid.h"
+#include "shapes/box.h"
+#include "shapes/planet.h"
+#include "shapes/space.h"
+#include "shapes/collectible.h"
+#include "algorithm/sdf.h"
+#include "algorithm/visibility.h"
+#include "algorithm/sensing.h"
+#include "algorithm/morton.h"
+#include "utils/generation.h"
+#include "utils/perf_counters.h"
+#include "utils/counters.h"
+#include "utils/chunks.h"
+
+// Everything the player controls for one frame, filled in by the window layer
+// (or a script when running headless)
+struct PlayerInput {
+    bool forward = false;
+    bool back = false;
+    bool left = false;
+    bool right = false;
+    bool up = false;
+    bool down = false;
+    bool boost = false;
+    bool stop = false;
+    bool shoot = false;
+
+    // Orbit camera angles in degrees, they decide what "forward" means
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    // Orbit camera distance, only the renderer uses it but replays keep it
+    float radius = 5.0f;
+
+    float deltaTime = 0.0f;
+};
+
+// Expected boid spawns per tick from this tick on, see WorldConfig::spawnCurve
+struct SpawnPoint {
+    long int tick;
+    float rate;
+};
+
+struct WorldConfig {
+    // Every random choice in the world is derived from this, see utils/random.h
+    uint64_t seed = 1;
+
+    int worldSize = 50;
+    int numBoxes = 10;
+    float boxMaxSize = 1.0f;
+    int initialBoids = 60;
+    int maxBoids = 2000;
+
+    float starsRadius = 200.0f;
+    float asteroidsRadius = 100.0f;
+    int numStars = 1000;
+    int numAsteroids = 100;
+
+    glm::vec3 playerStart = glm::vec3(100.0f, 0.0f, 0.0f);
+
+    // Spawn rate, interpolated between points sorted by tick. Empty keeps the
+    // default ramp from shouldSpawnBoid
+    std::vector<SpawnPoint> spawnCurve;
+
+    // Collisions no longer end the game, for long scripted runs
+    bool invulnerable = false;
+
+    // Read hardware counters around every phase, see World::phase_counters
+    bool perfCounters = false;
+
+    // Generate boxes, asteroids and stars chunk by chunk around the player
+    // instead of once at startup, see utils/chunks.h. numBoxes, numAsteroids
+    // and numStars are unused then.
+    bool streaming = false;
+    ChunkConfig chunks;
+};
+
+// Parts of World::step, timed every step
+typedef enum {
+  PHASE_INPUT,
+  PHASE_CHUNKS,
+  PHASE_SPAWN,
+  PHASE_CELLS,
+  PHASE_FLOCKS,
+  PHASE_BOIDS,
+  PHASE_COLLECTIBLES,
+  PHASE_OBSTACLES,
+  PHASE_PLANETS,
+  PHASE_PLAYER,
+  PHASE_COUNT
+} world_phase_t;
+
+const char* worldPhaseName(world_phase_t phase);
+
+// Direction the orbit camera looks in for the given angles
+glm::vec3 cameraFrontFromAngles(float yaw, float pitch);
+
+// The whole simulation without any window or GL context. The render layer
+// only reads from it.
+class World {
+public:
+    World(const WorldConfig& config_ = WorldConfig());
+    ~World();
+
+    // Obstacles are owned through raw pointers in box_map
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Advance one frame
+    void step(const PlayerInput& input);
+
+    // FNV-1a hash of the simulation state (player and bullets, boids by id,
+    // collectibles, planets, obstacles). Two runs that agree on it took the
+    // same path.
+    uint64_t checksum() const;
+
+    WorldConfig config;
+
+    Player player;
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>> box_map;
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> boid_map;
+    std::vector<Collectible> collectibles;
+    std::vector<Planet> planets;
+    Space space;
+
+    DistanceField obstacle_field;
+    // Adds and evicts obstacles in box_map and obstacle_field when streaming
+    ChunkStreamer chunks;
+    // Obstacles deleted by the last step, already gone from box_map. Only the
+    // addresses are left, for caches keyed by them.
+    std::vector<const Obstacle*> evicted_obstacles;
+    VisibilityCache goal_visibility;
+    SensingScheduler sensing;
+    MortonOrder cell_order;
+
+    long int frame = 0;
+    int num_boids = 0;
+    bool game_over = false;
+    // Ids are handed out in spawn order, they key each boid's random streams
+    // so the counter is per world, snapshots save and restore it
+    unsigned long next_boid_id = 0;
+
+    // Set when the player fired during the last step, for sounds and effects
+    bool shot_fired = false;
+
+    // Wall time of each phase of the last step, in seconds
+    double phase_seconds[PHASE_COUNT] = {};
+
+    // Hardware counter deltas of each phase of the last step, all zero unless
+    // config.perfCounters is set and the kernel let us open them. Opened by the
+    // first step, so they count the thread that calls step.
+    PerfCounters perf;
+    PerfSample phase_counters[PHASE_COUNT];
+
+    // Work counted during the last step (raycasts, neighbor pairs, ...), see
+    // utils/counters.h. Includes other threads counting at the same time.
+    CounterSample frame_counters;
+
+private:
+    // Boids to spawn this step, from the spawn curve
+    int spawnCount();
+    // Called on any collision with the player
+    void hitPlayer();
+};
+
+#endif // !WORLD_H
@@ -0,0 +1,15 @@
+#include "algorithm/lod.h"
+
+
+sim_lod_t selectSimLod(float distance, sim_lod_t current) {
+    // Boids have to come back inside the boundary by LOD_HYSTERESIS before they are
+    // promoted again, so ones hovering on a boundary don't flip tiers every tick
+    float nearRange = current == LOD_NEAR ? LOD_NEAR_RANGE : LOD_NEAR_RANGE - LOD_HYSTERESIS;
+    float farRange = current == LOD_FAR ? LOD_FAR_RANGE - LOD_HYSTERESIS : LOD_FAR_RANGE;
+
+    if (distance < nearRange)
+        return LOD_NEAR;
+    if (distance < farRange)
+        return LOD_MID;
+    return LOD_FAR;
+}
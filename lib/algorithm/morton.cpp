@@ -0,0 +1,81 @@
+#include "algorithm/morton.h"
+#include <algorithm>
+#include <chrono>
+
+
+// Spreads the low 21 bits of v so there are two zero bits between each
+static uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | (v << 32)) & 0x1f00000000ffffULL;
+    v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+    v = (v | (v << 8))  & 0x100f00f00f00f00fULL;
+    v = (v | (v << 4))  & 0x10c30c30c30c30c3ULL;
+    v = (v | (v << 2))  & 0x1249249249249249ULL;
+    return v;
+}
+
+uint64_t mortonCode(const std::tuple<int,int,int>& cell) {
+    // Bias so negative cells sort before positive ones
+    const int64_t bias = 1 << 20;
+    return spreadBits(static_cast<uint64_t>(std::get<0>(cell) + bias))
+        | (spreadBits(static_cast<uint64_t>(std::get<1>(cell) + bias)) << 1)
+        | (spreadBits(static_cast<uint64_t>(std::get<2>(cell) + bias)) << 2);
+}
+
+void MortonOrder::sort(const std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>>& boid_map, long int frame) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Last order for the cells still there, then the new ones. last is
+    // sorted, so whether a cell is new is a binary search.
+    entries.clear();
+    for (const Entry& entry : last) {
+        if (boid_map.count(entry.cell) != 0)
+            entries.push_back(entry);
+    }
+    for (const auto& [cell, boids] : boid_map) {
+        Entry entry{mortonCode(cell), cell};
+        if (!std::binary_search(last.begin(), last.end(), entry))
+            entries.push_back(entry);
+    }
+
+    size_t disorder = 0;
+    for (size_t i = 1; i < entries.size(); i++) {
+        if (entries[i] < entries[i - 1])
+            disorder++;
+    }
+
+    if (disorder == 0) {
+        lastMethod = SORT_NONE;
+    } else if (disorder * MORTON_DISORDER_RATIO < entries.size()
+            && frame - lastFullSort < MORTON_FULL_SORT_PERIOD) {
+        insertionSort();
+        lastMethod = SORT_INSERTION;
+    } else {
+        std::sort(entries.begin(), entries.end());
+        lastMethod = SORT_FULL;
+        lastFullSort = frame;
+    }
+
+    last.swap(entries);
+    cells.clear();
+    for (const Entry& entry : last) {
+        cells.push_back(entry.cell);
+    }
+
+    lastDisorder = disorder;
+    lastSortNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void MortonOrder::insertionSort() {
+    // Linear in the number of out of place keys, which is small frame to frame
+    for (size_t i = 1; i < entries.size(); i++) {
+        Entry entry = entries[i];
+        size_t j = i;
+        while (j > 0 && entry < entries[j - 1]) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+}
@@ -0,0 +1,96 @@
+#include "algorithm/nearest.h"
+#include <algorithm>
+#include <cmath>
+
+
+PointGrid::PointGrid(const std::vector<glm::vec3>& points_) : points(points_) {
+    if (points.empty())
+        return;
+    glm::vec3 lo = points[0], hi = points[0];
+    for (const glm::vec3& p : points) {
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    origin = lo;
+    // Cells sized for a few points each if they filled the bounds evenly. Flat
+    // or thin point sets have next to no volume, the largest side bounds the
+    // cell size from below for those.
+    glm::vec3 extent = glm::max(hi - lo, 1e-6f);
+    float cells = std::max(1.0f, float(points.size()) / POINT_GRID_POINTS_PER_CELL);
+    float largest = std::max(extent.x, std::max(extent.y, extent.z));
+    cellSize = std::max(std::cbrt(extent.x * extent.y * extent.z / cells), largest / cells);
+    for (;;) {
+        size_t cellCount = 1;
+        for (int axis = 0; axis < 3; axis++) {
+            dims[axis] = static_cast<int>(extent[axis] / cellSize) + 1;
+            cellCount *= dims[axis];
+        }
+        // Memory stays linear in the point count however the bounds are shaped
+        if (cellCount <= 8 * points.size() + 64)
+            break;
+        cellSize *= 1.5f;
+    }
+
+    // Counting sort by cell, indices stay ascending inside each cell
+    size_t cellCount = size_t(dims[0]) * dims[1] * dims[2];
+    cellStart.assign(cellCount + 1, 0);
+    std::vector<uint32_t> pointCell(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        const glm::vec3& p = points[i];
+        pointCell[i] = static_cast<uint32_t>(cellIndex(cellOf(p.x, 0), cellOf(p.y, 1), cellOf(p.z, 2)));
+        cellStart[pointCell[i] + 1]++;
+    }
+    for (size_t c = 0; c < cellCount; c++) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    indices.resize(points.size());
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < points.size(); i++) {
+        indices[fill[pointCell[i]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+int PointGrid::cellOf(float coordinate, int axis) const {
+    float cell = std::floor((coordinate - origin[axis]) / cellSize);
+    return static_cast<int>(std::min(std::max(cell, 0.0f), float(dims[axis] - 1)));
+}
+
+long PointGrid::nearest(const glm::vec3& p) const {
+    if (points.empty())
+        return -1;
+    // Queries outside the bounds start from the closest cell, the shells still
+    // reach every point
+    int cx = cellOf(p.x, 0), cy = cellOf(p.y, 1), cz = cellOf(p.z, 2);
+    long best = -1;
+    float bestDistance = INFINITY;
+    int maxRing = std::max(dims[0], std::max(dims[1], dims[2]));
+    for (int r = 0; r < maxRing; r++) {
+        for (int z = std::max(cz - r, 0); z <= std::min(cz + r, dims[2] - 1); z++) {
+            for (int y = std::max(cy - r, 0); y <= std::min(cy + r, dims[1] - 1); y++) {
+                // Cells inside the shell were searched by the smaller ones, off
+                // the shell's z and y faces only its two x ends are new
+                bool face = std::abs(z - cz) == r || std::abs(y - cy) == r;
+                int step = face || r == 0 ? 1 : 2 * r;
+                for (int x = face ? std::max(cx - r, 0) : cx - r; x <= std::min(cx + r, dims[0] - 1); x += step) {
+                    if (x < 0)
+                        continue;
+                    size_t cell = cellIndex(x, y, z);
+                    for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+                        uint32_t index = indices[i];
+                        glm::vec3 d = points[index] - p;
+                        float distance = glm::dot(d, d);
+                        if (distance < bestDistance || (distance == bestDistance && long(index) < best)) {
+                            bestDistance = distance;
+                            best = index;
+                        }
+                    }
+                }
+            }
+        }
+        // Every cell of the next shell is at least r whole cells from the query's
+        float reach = r * cellSize;
+        if (best >= 0 && bestDistance <= reach * reach)
+            break;
+    }
+    return best;
+}
@@ -0,0 +1,199 @@
+#include "algorithm/sdf.h"
+#include <algorithm>
+#include <cmath>
+
+#include "utils/counters.h"
+
+
+DistanceField::DistanceField(float voxelSize_, float band_)
+    : voxelSize(voxelSize_), band(band_), brickWorldSize(voxelSize_ * SDF_BRICK_SIZE) {}
+
+void DistanceField::build(const std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map) {
+    bricks.clear();
+    brick_obstacles.clear();
+    dirty.clear();
+
+    for (const auto& [cell, obstacles] : box_map) {
+        for (const Obstacle* obstacle : obstacles) {
+            markBricks(obstacle,
+                glm::vec3(obstacle->getMinX(), obstacle->getMinY(), obstacle->getMinZ()),
+                glm::vec3(obstacle->getMaxX(), obstacle->getMaxY(), obstacle->getMaxZ()), true);
+        }
+    }
+    rebuildDirty();
+}
+
+void DistanceField::addObstacle(const Obstacle* obstacle) {
+    markBricks(obstacle,
+        glm::vec3(obstacle->getMinX(), obstacle->getMinY(), obstacle->getMinZ()),
+        glm::vec3(obstacle->getMaxX(), obstacle->getMaxY(), obstacle->getMaxZ()), true);
+    rebuildDirty();
+}
+
+void DistanceField::removeObstacle(const Obstacle* obstacle, glm::vec3 oldMin, glm::vec3 oldMax) {
+    markBricks(obstacle, oldMin, oldMax, false);
+    rebuildDirty();
+}
+
+void DistanceField::moveObstacle(const Obstacle* obstacle, glm::vec3 oldMin, glm::vec3 oldMax) {
+    // Drop it from the bricks around the old bounds, then add it around the new ones.
+    // Bricks in both sets are only re-baked once.
+    markBricks(obstacle, oldMin, oldMax, false);
+    markBricks(obstacle,
+        glm::vec3(obstacle->getMinX(), obstacle->getMinY(), obstacle->getMinZ()),
+        glm::vec3(obstacle->getMaxX(), obstacle->getMaxY(), obstacle->getMaxZ()), true);
+    rebuildDirty();
+}
+
+void DistanceField::addObstacles(const std::vector<Obstacle*>& obstacles, const std::vector<BakedBrick>& baked) {
+    for (const Obstacle* obstacle : obstacles) {
+        markBricks(obstacle,
+            glm::vec3(obstacle->getMinX(), obstacle->getMinY(), obstacle->getMinZ()),
+            glm::vec3(obstacle->getMaxX(), obstacle->getMaxY(), obstacle->getMaxZ()), true);
+    }
+    for (const BakedBrick& brick : baked) {
+        Brick& adopted = bricks[brick.key];
+        adopted.distances.clear();
+        adopted.baked = brick.distances;
+        dirty.erase(brick.key);
+    }
+    if (!baked.empty())
+        version++;
+    rebuildDirty();
+}
+
+void DistanceField::removeObstacles(const std::vector<Obstacle*>& obstacles) {
+    for (const Obstacle* obstacle : obstacles) {
+        markBricks(obstacle,
+            glm::vec3(obstacle->getMinX(), obstacle->getMinY(), obstacle->getMinZ()),
+            glm::vec3(obstacle->getMaxX(), obstacle->getMaxY(), obstacle->getMaxZ()), false);
+    }
+    rebuildDirty();
+}
+
+DistanceField::brick_key_t DistanceField::positionToBrick(const glm::vec3& pos) const {
+    return std::make_tuple(
+        static_cast<int>(std::floor(pos.x / brickWorldSize)),
+        static_cast<int>(std::floor(pos.y / brickWorldSize)),
+        static_cast<int>(std::floor(pos.z / brickWorldSize)));
+}
+
+glm::vec3 DistanceField::brickOrigin(const brick_key_t& key) const {
+    return glm::vec3(std::get<0>(key), std::get<1>(key), std::get<2>(key)) * brickWorldSize;
+}
+
+void DistanceField::markBricks(const Obstacle* obstacle, glm::vec3 minCorner, glm::vec3 maxCorner, bool insert) {
+    // Every brick within the band of the obstacle bounds can see it
+    brick_key_t lo = positionToBrick(minCorner - glm::vec3(band));
+    brick_key_t hi = positionToBrick(maxCorner + glm::vec3(band));
+
+    for (int bx = std::get<0>(lo); bx <= std::get<0>(hi); bx++) {
+        for (int by = std::get<1>(lo); by <= std::get<1>(hi); by++) {
+            for (int bz = std::get<2>(lo); bz <= std::get<2>(hi); bz++) {
+                brick_key_t key = std::make_tuple(bx, by, bz);
+                std::vector<const Obstacle*>& list = brick_obstacles[key];
+                auto found = std::find(list.begin(), list.end(), obstacle);
+                if (insert && found == list.end()) {
+                    list.push_back(obstacle);
+                } else if (!insert && found != list.end()) {
+                    list.erase(found);
+                }
+                dirty.insert(key);
+            }
+        }
+    }
+}
+
+void DistanceField::rebuildDirty() {
+    if (!dirty.empty())
+        version++;
+    for (const brick_key_t& key : dirty) {
+        rebuildBrick(key);
+    }
+    dirty.clear();
+}
+
+void DistanceField::rebuildBrick(const brick_key_t& key) {
+    auto listIt = brick_obstacles.find(key);
+    if (listIt == brick_obstacles.end() || listIt->second.empty()) {
+        // Nothing nearby anymore, the brick is empty space
+        if (listIt != brick_obstacles.end())
+            brick_obstacles.erase(listIt);
+        bricks.erase(key);
+        return;
+    }
+
+    const int n = SDF_BRICK_SIZE + 1;
+    glm::vec3 origin = brickOrigin(key);
+    Brick& brick = bricks[key];
+    brick.baked = nullptr;
+    brick.distances.assign(n * n * n, band);
+
+    for (int k = 0; k < n; k++) {
+        for (int j = 0; j < n; j++) {
+            for (int i = 0; i < n; i++) {
+                glm::vec3 samplePos = origin + glm::vec3(i, j, k) * voxelSize;
+                float d = band;
+                for (const Obstacle* obstacle : listIt->second) {
+                    d = std::min(d, obstacle->signedDistance(samplePos));
+                }
+                brick.distances[(k * n + j) * n + i] = d;
+            }
+        }
+    }
+}
+
+std::vector<BakedBrick> DistanceField::bakedBricks() const {
+    std::vector<BakedBrick> result;
+    result.reserve(bricks.size());
+    for (const auto& [key, brick] : bricks) {
+        result.push_back(BakedBrick{key, brick.data()});
+    }
+    return result;
+}
+
+float DistanceField::sample(const glm::vec3& point, glm::vec3* gradient) const {
+    countEvent(COUNTER_FIELD_SAMPLES);
+    auto it = bricks.find(positionToBrick(point));
+    if (it == bricks.end()) {
+        if (gradient != nullptr)
+            *gradient = glm::vec3(0.0f);
+        return band;
+    }
+
+    const int n = SDF_BRICK_SIZE + 1;
+    const float* d = it->second.data();
+    glm::vec3 local = (point - brickOrigin(it->first)) / voxelSize;
+
+    int i = std::clamp(static_cast<int>(local.x), 0, SDF_BRICK_SIZE - 1);
+    int j = std::clamp(static_cast<int>(local.y), 0, SDF_BRICK_SIZE - 1);
+    int k = std::clamp(static_cast<int>(local.z), 0, SDF_BRICK_SIZE - 1);
+    float tx = glm::clamp(local.x - i, 0.0f, 1.0f);
+    float ty = glm::clamp(local.y - j, 0.0f, 1.0f);
+    float tz = glm::clamp(local.z - k, 0.0f, 1.0f);
+
+    auto at = [&](int di, int dj, int dk) {
+        return d[((k + dk) * n + (j + dj)) * n + (i + di)];
+    };
+    float c000 = at(0,0,0), c100 = at(1,0,0), c010 = at(0,1,0), c110 = at(1,1,0);
+    float c001 = at(0,0,1), c101 = at(1,0,1), c011 = at(0,1,1), c111 = at(1,1,1);
+
+    float c00 = glm::mix(c000, c100, tx);
+    float c10 = glm::mix(c010, c110, tx);
+    float c01 = glm::mix(c001, c101, tx);
+    float c11 = glm::mix(c011, c111, tx);
+    float c0 = glm::mix(c00, c10, ty);
+    float c1 = glm::mix(c01, c11, ty);
+
+    if (gradient != nullptr) {
+        // Analytic derivative of the trilinear interpolant, same 8 samples
+        float gx = glm::mix(glm::mix(c100 - c000, c110 - c010, ty),
+                            glm::mix(c101 - c001, c111 - c011, ty), tz);
+        float gy = glm::mix(c10 - c00, c11 - c01, tz);
+        float gz = c1 - c0;
+        glm::vec3 g(gx, gy, gz);
+        float len = glm::length(g);
+        *gradient = len > 0.0f ? g / len : glm::vec3(0.0f);
+    }
+    return glm::mix(c0, c1, tz);
+}
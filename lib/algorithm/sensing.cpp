@@ -0,0 +1,31 @@
+#include "algorithm/sensing.h"
+
+
+SensingScheduler::SensingScheduler(int period_, long budget_, float moveThreshold_)
+    : period(period_), budget(budget_), moveThreshold(moveThreshold_) {}
+
+void SensingScheduler::beginFrame() {
+    spent = 0;
+    refreshed = 0;
+    deferred = 0;
+}
+
+bool SensingScheduler::shouldRefresh(long staleness, float moved, float clearance, long cost) {
+    // A boid that may have closed half the gap to the obstacle it last saw
+    // can't trust its cache either
+    bool priority = moved > moveThreshold || moved > clearance * 0.5f;
+    bool due = staleness >= period;
+
+    if (!priority && !due)
+        return false;
+
+    long limit = priority ? budget : budget - static_cast<long>(budget * SENSE_PRIORITY_SHARE);
+    if (spent > 0 && spent + cost > limit) {
+        // Stays due and is picked up on a later frame
+        deferred++;
+        return false;
+    }
+    spent += cost;
+    refreshed++;
+    return true;
+}
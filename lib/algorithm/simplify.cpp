@@ -0,0 +1,320 @@
+#include "algorithm/simplify.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+
+// Symmetric 4x4 matrix of a sum of squared plane distances, upper triangle
+// row by row: xx xy xz xw yy yz yw zz zw ww
+struct Quadric {
+    double q[10] = {};
+
+    void addPlane(const glm::vec3& n, float d, double weight) {
+        double a = n.x, b = n.y, c = n.z, w = d;
+        q[0] += weight * a * a; q[1] += weight * a * b; q[2] += weight * a * c; q[3] += weight * a * w;
+        q[4] += weight * b * b; q[5] += weight * b * c; q[6] += weight * b * w;
+        q[7] += weight * c * c; q[8] += weight * c * w;
+        q[9] += weight * w * w;
+    }
+    Quadric& operator+=(const Quadric& other) {
+        for (int i = 0; i < 10; i++) {
+            q[i] += other.q[i];
+        }
+        return *this;
+    }
+    // Sum of the squared distances from p to every plane added
+    double eval(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double e = q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+            + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+            + q[7] * z * z + 2 * q[8] * z
+            + q[9];
+        return std::max(e, 0.0);
+    }
+};
+
+struct Collapse {
+    uint32_t src;
+    uint32_t dst;
+    double cost;
+};
+
+static uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return a < b ? uint64_t(a) << 32 | b : uint64_t(b) << 32 | a;
+}
+
+// Vertices of the triangles around v, v itself left out, sorted
+static void ringOf(uint32_t v, const std::vector<uint32_t>& tris, const std::vector<uint32_t>& triStart,
+        const std::vector<uint32_t>& triList, std::vector<uint32_t>& ring) {
+    ring.clear();
+    for (uint32_t i = triStart[v]; i < triStart[v + 1]; i++) {
+        const uint32_t* t = &tris[triList[i] * 3];
+        for (int k = 0; k < 3; k++) {
+            if (t[k] != v)
+                ring.push_back(t[k]);
+        }
+    }
+    std::sort(ring.begin(), ring.end());
+    ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+}
+
+std::vector<MeshLod> buildLodChain(const float* vertices, size_t vertexCount, size_t stride,
+        std::vector<uint32_t>& indices, int levels, float ratio, float maxError) {
+    std::vector<MeshLod> lods;
+    lods.push_back(MeshLod{0, static_cast<uint32_t>(indices.size()), 0.0f});
+    if (vertexCount == 0 || indices.size() < 3)
+        return lods;
+
+    // Weld vertices that only differ in their other attributes, rep is the
+    // first vertex of each welded one
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    auto position = [&](uint32_t v) {
+        return glm::vec3(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]);
+    };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        glm::vec3 pa = position(a), pb = position(b);
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b;
+    });
+    std::vector<uint32_t> weld(vertexCount);
+    std::vector<uint32_t> rep;
+    std::vector<glm::vec3> pos;
+    for (size_t i = 0; i < vertexCount; i++) {
+        uint32_t v = order[i];
+        if (i == 0 || position(v) != pos.back()) {
+            rep.push_back(v);
+            pos.push_back(position(v));
+        }
+        weld[v] = static_cast<uint32_t>(pos.size() - 1);
+    }
+    size_t welded = pos.size();
+
+    // Triangles over welded vertices, corner keeps the vertex each corner draws with
+    std::vector<uint32_t> tris, corner;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        uint32_t a = weld[indices[i]], b = weld[indices[i + 1]], c = weld[indices[i + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        tris.insert(tris.end(), {a, b, c});
+        corner.insert(corner.end(), {indices[i], indices[i + 1], indices[i + 2]});
+    }
+
+    // Every vertex starts with the planes of its triangles, open edges add a
+    // plane through the edge at right angles to its triangle
+    std::vector<Quadric> quadrics(welded);
+    std::vector<char> boundary(welded, 0);
+    std::vector<std::pair<uint64_t, uint32_t>> edges;
+    for (size_t t = 0; t < tris.size() / 3; t++) {
+        glm::vec3 p0 = pos[tris[t * 3]], p1 = pos[tris[t * 3 + 1]], p2 = pos[tris[t * 3 + 2]];
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(n);
+        if (length > 0.0f) {
+            n = n / length;
+            for (int k = 0; k < 3; k++) {
+                quadrics[tris[t * 3 + k]].addPlane(n, -glm::dot(n, p0), 1.0);
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            edges.push_back({edgeKey(tris[t * 3 + k], tris[t * 3 + (k + 1) % 3]), static_cast<uint32_t>(t)});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size(); i++) {
+        bool shared = (i > 0 && edges[i - 1].first == edges[i].first)
+            || (i + 1 < edges.size() && edges[i + 1].first == edges[i].first);
+        if (shared)
+            continue;
+        uint32_t a = uint32_t(edges[i].first >> 32), b = uint32_t(edges[i].first);
+        const uint32_t* t = &tris[edges[i].second * 3];
+        glm::vec3 n = glm::cross(pos[t[1]] - pos[t[0]], pos[t[2]] - pos[t[0]]);
+        glm::vec3 side = glm::cross(pos[b] - pos[a], n);
+        float length = glm::length(side);
+        if (length > 0.0f) {
+            side = side / length;
+            quadrics[a].addPlane(side, -glm::dot(side, pos[a]), MESH_LOD_BOUNDARY_WEIGHT);
+            quadrics[b].addPlane(side, -glm::dot(side, pos[a]), MESH_LOD_BOUNDARY_WEIGHT);
+        }
+        boundary[a] = boundary[b] = 1;
+    }
+
+    double costLimit = double(maxError) * maxError;
+    double worst = 0.0;
+    size_t triCount = tris.size() / 3;
+    size_t levelTris = triCount;
+    bool stuck = false;
+    std::vector<uint32_t> triStart, triList, ring, dstRing;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(welded);
+    std::vector<char> locked(welded);
+
+    for (int level = 1; level < levels && !stuck; level++) {
+        size_t target = static_cast<size_t>(levelTris * ratio);
+        // Passes of independent collapses: each one locks the vertices around
+        // it, so the checks of every other collapse in the pass stay valid
+        while (triCount > target) {
+            triStart.assign(welded + 1, 0);
+            for (uint32_t v : tris) {
+                triStart[v + 1]++;
+            }
+            for (size_t v = 0; v < welded; v++) {
+                triStart[v + 1] += triStart[v];
+            }
+            triList.resize(tris.size());
+            std::vector<uint32_t> fill(triStart.begin(), triStart.end() - 1);
+            for (size_t i = 0; i < tris.size(); i++) {
+                triList[fill[tris[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            std::vector<uint64_t> keys;
+            keys.reserve(tris.size());
+            for (size_t t = 0; t < tris.size() / 3; t++) {
+                for (int k = 0; k < 3; k++) {
+                    keys.push_back(edgeKey(tris[t * 3 + k], tris[t * 3 + (k + 1) % 3]));
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+            collapses.clear();
+            for (size_t i = 0; i < keys.size();) {
+                size_t run = i;
+                while (run < keys.size() && keys[run] == keys[i]) {
+                    run++;
+                }
+                bool openEdge = run - i == 1;
+                uint32_t a = uint32_t(keys[i] >> 32), b = uint32_t(keys[i]);
+                i = run;
+                // Border vertices only move along the border
+                Quadric sum = quadrics[a];
+                sum += quadrics[b];
+                Collapse best = {0, 0, -1.0};
+                for (int direction = 0; direction < 2; direction++) {
+                    uint32_t src = direction ? b : a, dst = direction ? a : b;
+                    if (boundary[src] && !(openEdge && boundary[dst]))
+                        continue;
+                    double cost = sum.eval(pos[dst]);
+                    if (best.cost < 0.0 || cost < best.cost)
+                        best = Collapse{src, dst, cost};
+                }
+                if (best.cost >= 0.0 && best.cost <= costLimit)
+                    collapses.push_back(best);
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+                if (x.cost != y.cost)
+                    return x.cost < y.cost;
+                return edgeKey(x.src, x.dst) < edgeKey(y.src, y.dst);
+            });
+
+            std::iota(remap.begin(), remap.end(), 0u);
+            std::fill(locked.begin(), locked.end(), 0);
+            size_t accepted = 0;
+            for (const Collapse& collapse : collapses) {
+                if (triCount <= target)
+                    break;
+                uint32_t src = collapse.src, dst = collapse.dst;
+                if (locked[src] || locked[dst])
+                    continue;
+
+                // Nothing but the triangles on the edge may share both ends,
+                // otherwise the collapse pinches the surface together
+                size_t onEdge = 0;
+                bool flips = false;
+                for (uint32_t i = triStart[src]; i < triStart[src + 1]; i++) {
+                    const uint32_t* t = &tris[triList[i] * 3];
+                    if (t[0] == dst || t[1] == dst || t[2] == dst) {
+                        onEdge++;
+                        continue;
+                    }
+                    glm::vec3 p[3], q[3];
+                    for (int k = 0; k < 3; k++) {
+                        p[k] = pos[t[k]];
+                        q[k] = t[k] == src ? pos[dst] : p[k];
+                    }
+                    glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                    float lengths = glm::length(before) * glm::length(after);
+                    if (lengths <= 0.0f || glm::dot(before, after) < 0.1f * lengths) {
+                        flips = true;
+                        break;
+                    }
+                }
+                if (flips)
+                    continue;
+                ringOf(src, tris, triStart, triList, ring);
+                ringOf(dst, tris, triStart, triList, dstRing);
+                size_t common = 0;
+                for (size_t i = 0, j = 0; i < ring.size() && j < dstRing.size();) {
+                    if (ring[i] < dstRing[j]) {
+                        i++;
+                    } else if (dstRing[j] < ring[i]) {
+                        j++;
+                    } else {
+                        common++;
+                        i++;
+                        j++;
+                    }
+                }
+                if (common > onEdge)
+                    continue;
+
+                remap[src] = dst;
+                quadrics[dst] += quadrics[src];
+                locked[src] = locked[dst] = 1;
+                for (uint32_t v : ring) {
+                    locked[v] = 1;
+                }
+                worst = std::max(worst, collapse.cost);
+                triCount -= onEdge;
+                accepted++;
+            }
+            if (accepted == 0) {
+                stuck = true;
+                break;
+            }
+
+            // Collapsed corners draw with the vertex they moved onto
+            size_t kept = 0;
+            for (size_t t = 0; t < tris.size() / 3; t++) {
+                uint32_t v[3], c[3];
+                for (int k = 0; k < 3; k++) {
+                    v[k] = remap[tris[t * 3 + k]];
+                    c[k] = v[k] == tris[t * 3 + k] ? corner[t * 3 + k] : rep[v[k]];
+                }
+                if (v[0] == v[1] || v[1] == v[2] || v[0] == v[2])
+                    continue;
+                for (int k = 0; k < 3; k++) {
+                    tris[kept * 3 + k] = v[k];
+                    corner[kept * 3 + k] = c[k];
+                }
+                kept++;
+            }
+            tris.resize(kept * 3);
+            corner.resize(kept * 3);
+            triCount = kept;
+        }
+
+        // A level that stopped short on the error bound is only kept when it
+        // still saves a fair part of the one before
+        if (triCount > target && triCount > levelTris * (1.0f + ratio) / 2.0f)
+            break;
+        lods.push_back(MeshLod{static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(corner.size()),
+            static_cast<float>(std::sqrt(worst))});
+        indices.insert(indices.end(), corner.begin(), corner.end());
+        levelTris = triCount;
+        if (triCount > target)
+            break;
+    }
+    return lods;
+}
+
+size_t selectMeshLod(const std::vector<MeshLod>& lods, float distance, float pixelsPerUnit, float maxPixels) {
+    size_t level = 0;
+    for (size_t i = 1; i < lods.size(); i++) {
+        if (lods[i].error * pixelsPerUnit > maxPixels * std::max(distance, 1e-6f))
+            break;
+        level = i;
+    }
+    return level;
+}
@@ -0,0 +1,54 @@
+#include "algorithm/visibility.h"
+#include <algorithm>
+
+#include "utils/counters.h"
+
+
+VisibilityCache::VisibilityCache(const DistanceField& field_)
+    : field(field_), goal_cell(0, 0, 0), field_version(field_.getVersion()) {}
+
+void VisibilityCache::update(const glm::vec3& goal_pos) {
+    std::tuple<int,int,int> cell = positionToCell(goal_pos);
+    if (cell != goal_cell || field.getVersion() != field_version) {
+        cache.clear();
+        goal_cell = cell;
+        field_version = field.getVersion();
+    }
+}
+
+bool VisibilityCache::visible(const std::tuple<int,int,int>& from_cell) {
+    auto it = cache.find(from_cell);
+    if (it != cache.end()) {
+        hits++;
+        return it->second;
+    }
+    misses++;
+    countEvent(COUNTER_RAYCASTS);
+    bool clear = traceCells(from_cell);
+    cache[from_cell] = clear;
+    return clear;
+}
+
+bool VisibilityCache::traceCells(const std::tuple<int,int,int>& from_cell) const {
+    // Sphere trace between the cell centers. A segment from any point of one
+    // cell to any point of the other stays within the larger of the two half
+    // diagonals of the center segment, so with that as the clearance a
+    // "visible" answer holds for the whole cell.
+    glm::vec3 start = cellCenter(from_cell);
+    glm::vec3 end = cellCenter(goal_cell);
+    float clearance = std::max(glm::length(cellHalfExtent(from_cell)), glm::length(cellHalfExtent(goal_cell)));
+    float length = glm::distance(start, end);
+    if (length <= 0.0f)
+        return field.sample(start) >= clearance;
+
+    glm::vec3 direction = (end - start) / length;
+    float minStep = field.getVoxelSize() / 2.0f;
+
+    for (float t = 0.0f; t < length; ) {
+        float d = field.sample(start + direction * t);
+        if (d < clearance)
+            return false;
+        t += std::max(d - clearance, minStep);
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#include "alloc/alloc_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<unsigned long> alloc_count{0};
+static std::atomic<unsigned long> alloc_bytes{0};
+
+void* operator new(std::size_t size) {
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+unsigned long allocationCount() { return alloc_count.load(std::memory_order_relaxed); }
+unsigned long allocationBytes() { return alloc_bytes.load(std::memory_order_relaxed); }
@@ -1,9 +1,11 @@
-#include "shapes/cylinder.h"
+#include "render/cylinder.h"
 #include <algorithm>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "utils/counters.h"
+
 
 Cylinder::Cylinder(glm::vec3 start_pos, float radius_, float height_, int segments_) : position(start_pos),
   radius(radius_), height(height_), segments(segments_)
@@ -120,6 +122,7 @@ void Cylinder::buildVertices() {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
+    countEvent(COUNTER_GL_CREATED, 3);
 
     glBindVertexArray(VAO);
 
@@ -0,0 +1,78 @@
+#include "render/gpu_timer.h"
+
+#include "utils/counters.h"
+
+
+const char* gpuPassName(gpu_pass_t pass) {
+    switch (pass) {
+        case GPU_PASS_BOIDS:        return "boids";
+        case GPU_PASS_COLLECTIBLES: return "collectibles";
+        case GPU_PASS_STARS:        return "stars";
+        case GPU_PASS_OBSTACLES:    return "obstacles";
+        case GPU_PASS_SUN:          return "sun";
+        case GPU_PASS_PLANETS:      return "planets";
+        case GPU_PASS_PLAYER:       return "player";
+        default:                    return "unknown";
+    }
+}
+
+GpuTimer::GpuTimer() {
+    supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (supported) {
+        glGenQueries(GPU_TIMER_LATENCY * GPU_PASS_COUNT, &queries[0][0]);
+        countEvent(COUNTER_GL_CREATED, GPU_TIMER_LATENCY * GPU_PASS_COUNT);
+    }
+}
+
+GpuTimer::~GpuTimer() {
+    if (supported) {
+        glDeleteQueries(GPU_TIMER_LATENCY * GPU_PASS_COUNT, &queries[0][0]);
+        countEvent(COUNTER_GL_DELETED, GPU_TIMER_LATENCY * GPU_PASS_COUNT);
+    }
+}
+
+void GpuTimer::beginFrame() {
+    if (!supported)
+        return;
+    slot = (slot + 1) % GPU_TIMER_LATENCY;
+
+    // This slot was issued GPU_TIMER_LATENCY frames ago
+    for (int p = 0; p < GPU_PASS_COUNT; p++) {
+        if (!pending[slot][p])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot][p], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[slot][p], GL_QUERY_RESULT, &ns);
+        stats[p].add(ns * 1e-6);
+        pending[slot][p] = false;
+    }
+}
+
+void GpuTimer::begin(gpu_pass_t pass) {
+    if (!supported || pending[slot][pass])
+        return;
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot][pass]);
+    active[pass] = true;
+}
+
+void GpuTimer::end(gpu_pass_t pass) {
+    if (!active[pass])
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    active[pass] = false;
+    pending[slot][pass] = true;
+}
+
+void GpuTimer::writeJson(std::ostream& out) const {
+    out << "{\n";
+    for (int p = 0; p < GPU_PASS_COUNT; p++) {
+        out << "\"" << gpuPassName(static_cast<gpu_pass_t>(p)) << "\": ";
+        stats[p].writeJson(out);
+        if (p + 1 < GPU_PASS_COUNT)
+            out << ",";
+    }
+    out << "}\n";
+}
@@ -0,0 +1,313 @@
+#include "render/hud.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+#include "render/mesh.h"
+#include "utils/profiler.h"
+#ifdef BOIDS_HUD_ALLOCS
+#include "alloc/alloc_counter.h"
+#endif
+
+// 3x5 pixel glyphs, the first character is the glyph, then five rows top to bottom
+static const char* const GLYPHS[] = {
+    "0111101101101111", "1010110010010111", "2111001111100111", "3111001111001111",
+    "4101101111001001", "5111100111001111", "6111100111101111", "7111001001001001",
+    "8111101111101111", "9111101111001111",
+    "A010101111101101", "B110101110101110", "C011100100100011", "D110101101101110",
+    "E111100110100111", "F111100110100100", "G011100101101011", "H101101111101101",
+    "I111010010010111", "J001001001101010", "K101101110101101", "L100100100100111",
+    "M101111111101101", "N110101101101101", "O010101101101010", "P110101110100100",
+    "Q010101101110011", "R110101110101101", "S011100010001110", "T111010010010010",
+    "U101101101101111", "V101101101101010", "W101101111111101", "X101101010101101",
+    "Y101101010010010", "Z111001010100111",
+    ".000000000000010", ":000010000010000", "/001001010100100", "%101001010100101",
+    "-000000111000000", "(001010010010001", ")100010010010100", "_000000000000111",
+    "?111001010000010",
+};
+
+// Atlas of 4x6 cells for ASCII 32..127, the DEL cell is solid for rectangles
+#define HUD_ATLAS_COLUMNS 16
+#define HUD_ATLAS_ROWS 6
+#define HUD_ATLAS_WIDTH (HUD_ATLAS_COLUMNS * 4)
+#define HUD_ATLAS_HEIGHT (HUD_ATLAS_ROWS * 6)
+#define HUD_SOLID_CHAR 127
+#define HUD_PIXEL 2.0f              // screen pixels per font pixel
+#define HUD_ADVANCE (4 * HUD_PIXEL)
+#define HUD_LINE (7 * HUD_PIXEL)
+#define HUD_FLOATS_PER_VERTEX 8     // x, y, u, v, r, g, b, a
+
+
+Hud::Hud() : shader("../shaders/hud.vs", "../shaders/hud.fs") {
+    unsigned char pixels[HUD_ATLAS_WIDTH * HUD_ATLAS_HEIGHT] = {};
+    auto cellOrigin = [](int c, int& x, int& y) {
+        x = ((c - 32) % HUD_ATLAS_COLUMNS) * 4;
+        y = ((c - 32) / HUD_ATLAS_COLUMNS) * 6;
+    };
+    for (const char* glyph : GLYPHS) {
+        int cx, cy;
+        cellOrigin(static_cast<unsigned char>(glyph[0]), cx, cy);
+        for (int i = 0; i < 15; i++) {
+            if (glyph[1 + i] == '1')
+                pixels[(cy + i / 3) * HUD_ATLAS_WIDTH + cx + i % 3] = 255;
+        }
+    }
+    int sx, sy;
+    cellOrigin(HUD_SOLID_CHAR, sx, sy);
+    for (int y = 0; y < 6; y++) {
+        for (int x = 0; x < 4; x++) {
+            pixels[(sy + y) * HUD_ATLAS_WIDTH + sx + x] = 255;
+        }
+    }
+
+    glGenTextures(1, &atlas);
+    countEvent(COUNTER_GL_CREATED);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, HUD_ATLAS_WIDTH, HUD_ATLAS_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    countEvent(COUNTER_GL_CREATED, 2);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLsizei stride = HUD_FLOATS_PER_VERTEX * sizeof(GLfloat);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(4 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+
+    vertices.reserve(4096 * 6 * HUD_FLOATS_PER_VERTEX);
+}
+
+Hud::~Hud() {
+    glDeleteTextures(1, &atlas);
+    glDeleteBuffers(1, &VBO);
+    glDeleteVertexArrays(1, &VAO);
+    countEvent(COUNTER_GL_DELETED, 3);
+}
+
+static void pushQuad(std::vector<GLfloat>& vertices, float x0, float y0, float x1, float y1,
+        float u0, float v0, float u1, float v1, glm::vec4 c) {
+    const float corners[6][4] = {
+        {x0, y0, u0, v0}, {x1, y0, u1, v0}, {x1, y1, u1, v1},
+        {x0, y0, u0, v0}, {x1, y1, u1, v1}, {x0, y1, u0, v1},
+    };
+    for (const float* corner : corners) {
+        vertices.insert(vertices.end(), {corner[0], corner[1], corner[2], corner[3], c.x, c.y, c.z, c.w});
+    }
+}
+
+void Hud::rect(float x, float y, float w, float h, glm::vec4 color) {
+    int col = (HUD_SOLID_CHAR - 32) % HUD_ATLAS_COLUMNS;
+    int row = (HUD_SOLID_CHAR - 32) / HUD_ATLAS_COLUMNS;
+    float u = (col * 4 + 1.5f) / HUD_ATLAS_WIDTH;
+    float v = (row * 6 + 1.5f) / HUD_ATLAS_HEIGHT;
+    pushQuad(vertices, x, y, x + w, y + h, u, v, u, v, color);
+}
+
+float Hud::text(float x, float y, const char* str, glm::vec4 color) {
+    for (; *str; str++, x += HUD_ADVANCE) {
+        int c = std::toupper(static_cast<unsigned char>(*str));
+        if (c == ' ')
+            continue;
+        if (c < 32 || c >= HUD_SOLID_CHAR)
+            c = '?';
+        int col = (c - 32) % HUD_ATLAS_COLUMNS;
+        int row = (c - 32) / HUD_ATLAS_COLUMNS;
+        pushQuad(vertices, x, y, x + 3 * HUD_PIXEL, y + 5 * HUD_PIXEL,
+            float(col * 4) / HUD_ATLAS_WIDTH, float(row * 6) / HUD_ATLAS_HEIGHT,
+            float(col * 4 + 3) / HUD_ATLAS_WIDTH, float(row * 6 + 5) / HUD_ATLAS_HEIGHT, color);
+    }
+    return x;
+}
+
+float Hud::bar(float x, float y, const char* label, double ms, double fullMs, glm::vec4 color) {
+    const float width = 200.0f;
+    text(x, y, label, glm::vec4(0.8f, 0.8f, 0.8f, 1.0f));
+    float length = static_cast<float>(std::min(ms / fullMs, 1.0)) * width;
+    rect(x + 140.0f, y, width, 5 * HUD_PIXEL, glm::vec4(1.0f, 1.0f, 1.0f, 0.1f));
+    rect(x + 140.0f, y, std::max(length, 1.0f), 5 * HUD_PIXEL, color);
+    char value[32];
+    std::snprintf(value, sizeof(value), "%.3f", ms);
+    return text(x + 150.0f + width, y, value, glm::vec4(1.0f));
+}
+
+void Hud::draw(const World& world, const Timer& timer, const GpuTimer& gpu, int width, int height) {
+    uint64_t start = profilerNow();
+
+#ifdef BOIDS_HUD_ALLOCS
+    unsigned long allocs = allocationCount();
+    frame_allocs = allocs - last_allocs;
+    last_allocs = allocs;
+#endif
+    MeshStats meshes = meshStats();
+    frame_draws = meshes.draw_calls - last_draws;
+    CounterSample counters = countersSnapshot();
+    frame_counters = counterDelta(last_counters, counters);
+    last_draws = meshes.draw_calls;
+    last_counters = counters;
+
+    if (!visible)
+        return;
+    PROFILE_ZONE("Hud::draw");
+
+    const glm::vec4 white(1.0f);
+    const glm::vec4 grey(0.8f, 0.8f, 0.8f, 1.0f);
+    const glm::vec4 green(0.2f, 0.9f, 0.3f, 1.0f);
+    const glm::vec4 yellow(0.95f, 0.85f, 0.2f, 1.0f);
+    const glm::vec4 red(1.0f, 0.25f, 0.2f, 1.0f);
+    const glm::vec4 cyan(0.3f, 0.8f, 1.0f, 1.0f);
+    const double budgetMs = 1000.0 / 60.0;
+
+    char line[128];
+    float x = 16.0f, y = 16.0f;
+    vertices.clear();
+
+    // Background, its height is patched in once the layout is done
+    size_t panel = vertices.size();
+    rect(x - 8.0f, y - 8.0f, 540.0f, 0.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+
+    // Frame time graph over the last HUD_GRAPH_FRAMES frames, full height is two budgets
+    const FrameStats& frames = timer.getStats();
+    size_t shown = std::min<size_t>(frames.size(), HUD_GRAPH_FRAMES);
+    double sum = 0.0, worst = 0.0;
+    for (size_t age = 0; age < shown; age++) {
+        sum += frames.recent(age);
+        worst = std::max(worst, frames.recent(age));
+    }
+    double lastMs = shown ? frames.recent(0) : 0.0;
+    double avgMs = shown ? sum / shown : 0.0;
+    std::snprintf(line, sizeof(line), "FPS %.0f  FRAME %.2f MS  AVG %.2f  MAX %.2f  HITCHES %ld",
+        avgMs > 0.0 ? 1000.0 / avgMs : 0.0, lastMs, avgMs, worst, frames.getHitchCount());
+    text(x, y, line, white);
+    y += HUD_LINE;
+
+    const float graphHeight = 60.0f, column = 2.0f;
+    float graphBottom = y + graphHeight;
+    rect(x, y, HUD_GRAPH_FRAMES * column, graphHeight, glm::vec4(1.0f, 1.0f, 1.0f, 0.08f));
+    for (size_t age = 0; age < shown; age++) {
+        double ms = frames.recent(age);
+        float h = static_cast<float>(std::min(ms / (2.0 * budgetMs), 1.0)) * graphHeight;
+        glm::vec4 color = ms <= budgetMs ? green : (ms <= 2.0 * budgetMs ? yellow : red);
+        rect(x + (HUD_GRAPH_FRAMES - 1 - age) * column, graphBottom - h, column, h, color);
+    }
+    rect(x, graphBottom - graphHeight / 2.0f, HUD_GRAPH_FRAMES * column, 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 0.5f));
+    y = graphBottom + HUD_LINE / 2.0f;
+
+    // CPU phases of the last World::step, a full bar is half the frame budget
+    text(x, y, "CPU PHASES (MS)", grey);
+    y += HUD_LINE;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        bar(x, y, worldPhaseName(static_cast<world_phase_t>(p)), world.phase_seconds[p] * 1000.0, budgetMs / 2.0, cyan);
+        y += HUD_LINE;
+    }
+
+    if (gpu.isSupported()) {
+        text(x, y, "GPU PASSES (MS)", grey);
+        y += HUD_LINE;
+        for (int p = 0; p < GPU_PASS_COUNT; p++) {
+            const FrameStats& pass = gpu.getStats(static_cast<gpu_pass_t>(p));
+            bar(x, y, gpuPassName(static_cast<gpu_pass_t>(p)), pass.size() ? pass.recent(0) : 0.0, budgetMs / 2.0, yellow);
+            y += HUD_LINE;
+        }
+    }
+
+    size_t obstacles = 0;
+    for (const auto& [cell, cellObstacles] : world.box_map) {
+        obstacles += cellObstacles.size();
+    }
+    y += HUD_LINE / 2.0f;
+    std::snprintf(line, sizeof(line), "BOIDS %d  COLLECTIBLES %zu  OBSTACLES %zu  BULLETS %zu",
+        world.num_boids, world.collectibles.size(), obstacles, world.player.getBullets().size());
+    text(x, y, line, white);
+    y += HUD_LINE;
+    // Every GL name the renderer generated minus the ones it deleted
+    uint64_t gl_objects = counters.values[COUNTER_GL_CREATED] - counters.values[COUNTER_GL_DELETED];
+    std::snprintf(line, sizeof(line), "DRAWS %lu  MESHES %ld  GL OBJECTS %llu", frame_draws, meshes.live_meshes,
+        static_cast<unsigned long long>(gl_objects));
+    text(x, y, line, white);
+    y += HUD_LINE;
+#ifdef BOIDS_HUD_ALLOCS
+    std::snprintf(line, sizeof(line), "ALLOCS/FRAME %lu  HUD %.3f MS", frame_allocs, build_ms);
+#else
+    std::snprintf(line, sizeof(line), "HUD %.3f MS", build_ms);
+#endif
+    text(x, y, line, white);
+    y += HUD_LINE;
+    if (world.config.streaming) {
+        std::snprintf(line, sizeof(line), "CHUNKS %zu  PENDING %zu  %.1f MB", world.chunks.loadedCount(),
+            world.chunks.pendingCount(), world.chunks.loadedBytes() / double(1 << 20));
+        text(x, y, line, white);
+        y += HUD_LINE;
+    }
+
+    // Work counters of the last frame, two per line
+    y += HUD_LINE / 2.0f;
+    text(x, y, "WORK PER FRAME", grey);
+    y += HUD_LINE;
+    for (int c = 0; c < COUNTER_COUNT; c += 2) {
+        int length = std::snprintf(line, sizeof(line), "%-16s %8llu", counterName(static_cast<counter_t>(c)),
+            static_cast<unsigned long long>(frame_counters.values[c]));
+        if (c + 1 < COUNTER_COUNT) {
+            std::snprintf(line + length, sizeof(line) - length, "   %-16s %8llu", counterName(static_cast<counter_t>(c + 1)),
+                static_cast<unsigned long long>(frame_counters.values[c + 1]));
+        }
+        text(x, y, line, white);
+        y += HUD_LINE;
+    }
+
+    // Corners 2, 4 and 5 of the background quad are its bottom edge
+    for (int corner : {2, 4, 5}) {
+        vertices[panel + corner * HUD_FLOATS_PER_VERTEX + 1] = y + 4.0f;
+    }
+
+    submit(width, height);
+
+    build_ms = (profilerNow() - start) * 1e-6;
+}
+
+void Hud::drawProgress(const char* label, float fraction, int width, int height) {
+    PROFILE_ZONE("Hud::drawProgress");
+    const float barWidth = 400.0f, barHeight = 6 * HUD_PIXEL;
+    float x = (width - barWidth) / 2.0f;
+    float y = height / 2.0f;
+    vertices.clear();
+
+    char line[128];
+    std::snprintf(line, sizeof(line), "LOADING %3.0f%%  %s", std::clamp(fraction, 0.0f, 1.0f) * 100.0f, label);
+    text(x, y - HUD_LINE * 1.5f, line, glm::vec4(1.0f));
+    rect(x, y, barWidth, barHeight, glm::vec4(1.0f, 1.0f, 1.0f, 0.15f));
+    rect(x, y, std::clamp(fraction, 0.0f, 1.0f) * barWidth, barHeight, glm::vec4(0.3f, 0.8f, 1.0f, 1.0f));
+    submit(width, height);
+}
+
+void Hud::submit(int width, int height) {
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    shader.use();
+    shader.setVec2("screen", static_cast<float>(width), static_cast<float>(height));
+    shader.setInt("atlas", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STREAM_DRAW);
+    countEvent(COUNTER_GL_UPLOADS);
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / HUD_FLOATS_PER_VERTEX);
+    glBindVertexArray(0);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,232 @@
+#include "render/mesh.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/noise.hpp>
+#include <algorithm>
+#include <cmath>
+
+#include "utils/counters.h"
+
+static MeshStats stats = {0, 0};
+
+MeshStats meshStats() {
+    return stats;
+}
+
+Mesh uploadMesh(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, bool withNormals) {
+    Mesh mesh;
+    mesh.indexCount = indices.size();
+    stats.live_meshes++;
+    countEvent(COUNTER_GL_UPLOADS);
+
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.VBO);
+    glGenBuffers(1, &mesh.EBO);
+    countEvent(COUNTER_GL_CREATED, 3);
+
+    glBindVertexArray(mesh.VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+    GLsizei stride = (withNormals ? 6 : 3) * sizeof(GLfloat);
+
+    // Position attribute
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+
+    if (withNormals) {
+        // Normal attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(1);
+    }
+
+    glBindVertexArray(0);
+    return mesh;
+}
+
+void drawMesh(const Mesh& mesh) {
+    stats.draw_calls++;
+    glBindVertexArray(mesh.VAO);
+    glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+}
+
+void drawMeshRange(const Mesh& mesh, GLuint first, GLsizei count) {
+    stats.draw_calls++;
+    glBindVertexArray(mesh.VAO);
+    glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (GLvoid*)(first * sizeof(GLuint)));
+    glBindVertexArray(0);
+}
+
+void destroyMesh(Mesh& mesh) {
+    if (mesh.VAO != 0) {
+        stats.live_meshes--;
+        countEvent(COUNTER_GL_DELETED, 3);
+    }
+    glDeleteBuffers(1, &mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    glDeleteVertexArrays(1, &mesh.VAO);
+    mesh = Mesh();
+}
+
+// Shared by spheres and asteroids, offsetRadius gives the radius at stack i, sector j
+template<typename RadiusFn>
+static void appendStackedSphere(float radius, glm::vec3 center, RadiusFn offsetRadius,
+        std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) {
+    int sectorCount = std::max(18, static_cast<int>(radius * 10)); // Higher for larger radii
+    int stackCount = std::max(9, static_cast<int>(radius * 5));    // Proportionally lower than sectors
+
+    float sectorStep = 2 * M_PI / sectorCount;
+    float stackStep = M_PI / stackCount;
+    GLuint base = vertices.size() / 6;
+
+    for (int i = 0; i <= stackCount; ++i) {
+        float stackAngle = M_PI / 2 - i * stackStep;    // from pi/2 to -pi/2
+
+        for (int j = 0; j <= sectorCount; ++j) {
+            float sectorAngle = j * sectorStep;         // from 0 to 2pi
+            glm::vec3 normal(cosf(stackAngle) * cosf(sectorAngle),
+                             cosf(stackAngle) * sinf(sectorAngle),
+                             sinf(stackAngle));
+            glm::vec3 vertex = center + normal * offsetRadius(i, j);
+
+            vertices.push_back(vertex.x);
+            vertices.push_back(vertex.y);
+            vertices.push_back(vertex.z);
+            vertices.push_back(normal.x);
+            vertices.push_back(normal.y);
+            vertices.push_back(normal.z);
+        }
+    }
+
+    // Two triangles per quad, the poles only need one
+    for (int i = 0; i < stackCount; ++i) {
+        GLuint k1 = base + i * (sectorCount + 1);       // beginning of current stack
+        GLuint k2 = k1 + sectorCount + 1;               // beginning of next stack
+
+        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
+            if (i != 0) {
+                indices.push_back(k1);
+                indices.push_back(k2);
+                indices.push_back(k1 + 1);
+            }
+            if (i != (stackCount - 1)) {
+                indices.push_back(k1 + 1);
+                indices.push_back(k2);
+                indices.push_back(k2 + 1);
+            }
+        }
+    }
+}
+
+void appendSphere(float radius, glm::vec3 center, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) {
+    appendStackedSphere(radius, center, [radius](int, int) { return radius; }, vertices, indices);
+}
+
+void appendAsteroid(float radius, Rng& rng, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) {
+    // Parameters for noise
+    float noiseScale = 0.5f; // Scale factor for noise strength
+    float noiseFrequency = 0.2f; // Frequency for noise patterns
+
+    appendStackedSphere(radius, glm::vec3(0.0f), [&](int i, int j) {
+        float randomOffset = rng.uniform(-1.0f, 1.0f);  // Random offset for each vertex
+        float noiseValue = glm::simplex(glm::vec3(i * noiseFrequency + randomOffset,
+                                                  j * noiseFrequency + randomOffset,
+                                                  0.0f));
+        return radius + noiseValue * noiseScale;
+    }, vertices, indices);
+}
+
+void appendBox(float width, float height, float depth, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) {
+    float w = width / 2, h = height / 2, d = depth / 2;
+    GLuint base = vertices.size() / 6;
+
+    // Four corners per face so every face gets a flat normal
+    const GLfloat faces[] = {
+        // Front face
+        -w, -h, -d,  0.0f, 0.0f, -1.0f,
+         w, -h, -d,  0.0f, 0.0f, -1.0f,
+         w,  h, -d,  0.0f, 0.0f, -1.0f,
+        -w,  h, -d,  0.0f, 0.0f, -1.0f,
+        // Back face
+        -w, -h,  d,  0.0f, 0.0f, 1.0f,
+         w, -h,  d,  0.0f, 0.0f, 1.0f,
+         w,  h,  d,  0.0f, 0.0f, 1.0f,
+        -w,  h,  d,  0.0f, 0.0f, 1.0f,
+        // Left face
+        -w, -h, -d,  -1.0f, 0.0f, 0.0f,
+        -w,  h, -d,  -1.0f, 0.0f, 0.0f,
+        -w,  h,  d,  -1.0f, 0.0f, 0.0f,
+        -w, -h,  d,  -1.0f, 0.0f, 0.0f,
+        // Right face
+         w, -h, -d,  1.0f, 0.0f, 0.0f,
+         w,  h, -d,  1.0f, 0.0f, 0.0f,
+         w,  h,  d,  1.0f, 0.0f, 0.0f,
+         w, -h,  d,  1.0f, 0.0f, 0.0f,
+        // Bottom face
+        -w, -h, -d,  0.0f, -1.0f, 0.0f,
+         w, -h, -d,  0.0f, -1.0f, 0.0f,
+         w, -h,  d,  0.0f, -1.0f, 0.0f,
+        -w, -h,  d,  0.0f, -1.0f, 0.0f,
+        // Top face
+        -w,  h, -d,  0.0f, 1.0f, 0.0f,
+         w,  h, -d,  0.0f, 1.0f, 0.0f,
+         w,  h,  d,  0.0f, 1.0f, 0.0f,
+        -w,  h,  d,  0.0f, 1.0f, 0.0f,
+    };
+    vertices.insert(vertices.end(), std::begin(faces), std::end(faces));
+
+    for (GLuint face = 0; face < 6; face++) {
+        GLuint k = base + face * 4;
+        indices.insert(indices.end(), {k, k + 1, k + 2, k + 2, k + 3, k});
+    }
+}
+
+void appendPyramid(float size, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices) {
+    float halfSize = size / 2.0f;
+    GLuint base = vertices.size() / 3;
+
+    vertices.insert(vertices.end(), {
+        -halfSize, 0.0f, -halfSize,   // Base - bottom left
+         halfSize, 0.0f, -halfSize,   // Base - bottom right
+         halfSize, 0.0f,  halfSize,   // Base - top right
+        -halfSize, 0.0f,  halfSize,   // Base - top left
+         0.0f,     size,  0.0f        // Apex
+    });
+
+    const GLuint faces[] = {
+        0, 1, 2,    // Base face
+        0, 2, 3,
+        0, 1, 4,    // Side faces
+        1, 2, 4,
+        2, 3, 4,
+        3, 0, 4
+    };
+    for (GLuint index : faces) {
+        indices.push_back(base + index);
+    }
+}
+
+glm::mat4 pyramidOrientation(glm::vec3 direction) {
+    if (glm::length(direction) <= 0.0f)
+        return glm::mat4(1.0f);
+
+    glm::vec3 forward = glm::normalize(direction);
+    glm::vec3 up(0.0f, 1.0f, 0.0f);  // World up vector
+
+    // Compute right and adjusted up vectors to create the correct orientation
+    glm::vec3 right = glm::normalize(glm::cross(up, forward));
+    glm::vec3 adjustedUp = glm::cross(forward, right);
+
+    glm::mat4 rotationMatrix = glm::mat4(1.0f);
+    rotationMatrix[0] = glm::vec4(right, 0.0f);
+    rotationMatrix[1] = glm::vec4(adjustedUp, 0.0f);
+    rotationMatrix[2] = glm::vec4(forward, 0.0f);
+
+    // Tip the apex over by 90 degrees so it leads the movement
+    glm::mat4 rotation90 = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), right);
+    return rotation90 * rotationMatrix;
+}
@@ -0,0 +1,135 @@
+#include "render/model.h"
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+#include "algorithm/nearest.h"
+#include "utils/asset_archive.h"
+#include "utils/mesh_cache.h"
+#include "utils/profiler.h"
+
+
+// Faces over the sampled vertices only, a corner whose vertex was dropped
+// goes to the nearest sampled one. sampled holds the sampled positions in
+// reduced index order.
+static std::vector<GLuint> processFaces(const aiMesh* mesh, const std::unordered_map<unsigned int, unsigned int>& vertexMapping, 
+                                        const PointGrid& sampled) {
+    std::vector<GLuint> newIndices;
+    newIndices.reserve(mesh->mNumFaces * 3);
+
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        aiFace face = mesh->mFaces[i];
+        std::vector<unsigned int> faceIndices;
+
+        for (unsigned int j = 0; j < face.mNumIndices; j++) {
+            unsigned int originalIndex = face.mIndices[j];
+            
+            // Check if the original index is in the map (i.e., if it was sampled)
+            auto mapped = vertexMapping.find(originalIndex);
+            if (mapped != vertexMapping.end()) {
+                // Add the mapped reduced index for this face
+                faceIndices.push_back(mapped->second);
+            } else {
+                // Find the nearest sampled vertex and add that index
+                const aiVector3D& v = mesh->mVertices[originalIndex];
+                faceIndices.push_back(static_cast<unsigned int>(sampled.nearest(glm::vec3(v.x, v.y, v.z))));
+            }
+        }
+
+        // Add the face to newIndices if it has 3 indices (valid triangle)
+        if (faceIndices.size() == 3) {
+            newIndices.push_back(faceIndices[0]);
+            newIndices.push_back(faceIndices[1]);
+            newIndices.push_back(faceIndices[2]);
+        }
+    }
+
+    return newIndices;
+}
+
+// Hands the levels to a caller that asked for them, trims indices to the full mesh otherwise
+static void useLevels(std::vector<GLuint>& indices, std::vector<MeshLod>& levels, std::vector<MeshLod>* lods) {
+    if (lods)
+        *lods = std::move(levels);
+    else
+        indices.resize(levels[0].index_count);
+}
+
+void loadModel(std::vector<GLfloat>& unrotatedVertices, std::vector<GLuint>& indices, const std::string modelPath, float scale, int vertexSampleRate,
+               std::vector<MeshLod>* lods){
+    PROFILE_ZONE("loadModel");
+    std::string storage;
+    AssetView source = readAsset(modelPath, storage);
+    if (!source) {
+        std::cerr << "Error loading model: could not read " << modelPath << std::endl;
+        return;
+    }
+    // Decimated and simplified before, by this scale and sample rate, from the model as it is now
+    std::vector<MeshLod> levels;
+    if (loadCachedMesh(MESH_CACHE_DIR, source.hash, scale, vertexSampleRate, unrotatedVertices, indices, levels)) {
+        useLevels(indices, levels, lods);
+        return;
+    }
+
+    // Initialize Assimp importer
+    Assimp::Importer importer;
+    const unsigned int flags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals |
+        aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes;
+    // Parsed from memory, the extension tells Assimp the format
+    std::string extension = modelPath.substr(modelPath.find_last_of('.') + 1);
+    const aiScene* scene = importer.ReadFileFromMemory(source.data, source.size, flags, extension.c_str());
+
+    if (!scene || !scene->mRootNode || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
+        std::cerr << "Error loading model: " << importer.GetErrorString() << std::endl;
+        return;
+    }
+
+    // Process the first mesh in the scene
+    aiMesh* mesh = scene->mMeshes[0];
+    
+    std::unordered_map<unsigned int, unsigned int> vertexMapping;  // Maps original index to reduced index
+    std::vector<glm::vec3> sampled;                                 // Unscaled positions by reduced index
+    int reducedIndex = 0;
+    size_t first = unrotatedVertices.size();
+
+    // Extract and scale vertices, sampling as needed
+    int index = 0;
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+        if (index % vertexSampleRate == 0) {
+            // Store the mapping from original index to reduced index
+            vertexMapping[i] = reducedIndex++;
+            sampled.push_back(glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z));
+
+            // Push scaled vertex positions
+            unrotatedVertices.push_back(mesh->mVertices[i].x * scale);
+            unrotatedVertices.push_back(mesh->mVertices[i].y * scale);
+            unrotatedVertices.push_back(mesh->mVertices[i].z * scale);
+
+            // Push normals (no scaling needed)
+            unrotatedVertices.push_back(mesh->mNormals[i].x);
+            unrotatedVertices.push_back(mesh->mNormals[i].y);
+            unrotatedVertices.push_back(mesh->mNormals[i].z);
+        }
+        index++;
+    }
+
+    indices = processFaces(mesh, vertexMapping, PointGrid(sampled));
+
+    // Levels are always built, the cached file serves callers with and without them
+    glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+    for (const glm::vec3& p : sampled) {
+        lo = glm::min(lo, p * scale);
+        hi = glm::max(hi, p * scale);
+    }
+    float radius = sampled.empty() ? 0.0f : glm::length(hi - lo) * 0.5f;
+    size_t vertexFloats = unrotatedVertices.size() - first;
+    levels = buildLodChain(unrotatedVertices.data() + first, vertexFloats / 6, 6, indices,
+        MESH_LOD_LEVELS, MESH_LOD_RATIO, MESH_LOD_MAX_ERROR * radius);
+    storeCachedMesh(MESH_CACHE_DIR, source.hash, scale, vertexSampleRate,
+        unrotatedVertices.data() + first, vertexFloats, indices, levels);
+    useLevels(indices, levels, lods);
+}
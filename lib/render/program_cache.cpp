@@ -0,0 +1,190 @@
+#include "render/program_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "utils/counters.h"
+#include "utils/profiler.h"
+
+struct ProgramCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;            // GLenum from glGetProgramBinary
+    uint32_t length;
+};
+
+
+static uint64_t fnv1a(uint64_t hash, std::string_view text) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    // Separates fields, "ab" + "c" must not hash like "a" + "bc"
+    hash ^= 0xff;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+static std::string glString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+static bool linked(GLuint program, const std::string& name) {
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::PROGRAM_LINKING_ERROR of " << name << "\n" << infoLog << std::endl;
+    }
+    return success;
+}
+
+static void checkCompiled(GLuint shader, const std::string& name) {
+    GLint success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::SHADER_COMPILATION_ERROR of " << name << "\n" << infoLog << std::endl;
+    }
+}
+
+ProgramCache::ProgramCache(const std::string& dir_) : dir(dir_) {
+    driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+    GLint formats = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    binaries = formats > 0;
+    parallel = GLEW_KHR_parallel_shader_compile;
+    // As many compiler threads as the driver likes
+    if (parallel)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    if (binaries) {
+        std::error_code error;
+        std::filesystem::create_directories(dir, error);
+    }
+}
+
+GLuint ProgramCache::build(const std::string& name, std::string_view vertex, std::string_view fragment,
+        std::string_view geometry) {
+    PROFILE_ZONE("ProgramCache::build");
+    uint64_t key = 14695981039346656037ULL;
+    for (std::string_view text : {std::string_view(driver), vertex, fragment, geometry}) {
+        key = fnv1a(key, text);
+    }
+    char file[32];
+    std::snprintf(file, sizeof(file), "%016llx.bin", static_cast<unsigned long long>(key));
+    std::string path = dir + "/" + file;
+
+    GLuint program = glCreateProgram();
+    countEvent(COUNTER_GL_CREATED);
+    if (binaries && load(path, program)) {
+        hits++;
+        return program;
+    }
+    misses++;
+
+    Pending job{program, {0, 0, 0}, name, binaries ? path : ""};
+    const GLenum types[3] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER};
+    const std::string_view sources[3] = {vertex, fragment, geometry};
+    for (int i = 0; i < 3; i++) {
+        if (sources[i].empty())
+            continue;
+        // Straight from the archive mapping, sized since it is not null terminated
+        const char* code = sources[i].data();
+        GLint length = sources[i].size();
+        job.shaders[i] = glCreateShader(types[i]);
+        countEvent(COUNTER_GL_CREATED);
+        glShaderSource(job.shaders[i], 1, &code, &length);
+        glCompileShader(job.shaders[i]);
+        glAttachShader(program, job.shaders[i]);
+    }
+    if (binaries)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    // Only queued with the parallel extension, checking any status here would wait for it
+    glLinkProgram(program);
+    pending.push_back(job);
+    if (!parallel)
+        finish();
+    return program;
+}
+
+void ProgramCache::finish() {
+    PROFILE_ZONE("ProgramCache::finish");
+    for (Pending& job : pending) {
+        for (GLuint shader : job.shaders) {
+            if (shader == 0)
+                continue;
+            checkCompiled(shader, job.name);
+            glDetachShader(job.program, shader);
+            glDeleteShader(shader);
+            countEvent(COUNTER_GL_DELETED);
+        }
+        if (linked(job.program, job.name) && !job.path.empty())
+            store(job.path, job.program);
+    }
+    pending.clear();
+}
+
+bool ProgramCache::ready() {
+    if (!parallel)
+        return pending.empty();
+    for (const Pending& job : pending) {
+        GLint done = GL_FALSE;
+        glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done)
+            return false;
+    }
+    return true;
+}
+
+bool ProgramCache::load(const std::string& path, GLuint program) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ProgramCacheHeader header;
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION
+            || header.length != data.size() - sizeof(header))
+        return false;
+    glProgramBinary(program, header.format, data.data() + sizeof(header), header.length);
+    // Drivers may still refuse a binary they wrote, the caller compiles then
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success;
+}
+
+void ProgramCache::store(const std::string& path, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> data(sizeof(ProgramCacheHeader) + length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, data.data() + sizeof(ProgramCacheHeader));
+    ProgramCacheHeader header = {PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, format, static_cast<uint32_t>(length)};
+    std::memcpy(data.data(), &header, sizeof(header));
+    // Written aside and renamed, a crash mid write never leaves a bad entry
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if (!out)
+            return;
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+}
+
+ProgramCache& programCache() {
+    static ProgramCache cache("boids_shader_cache");
+    return cache;
+}
@@ -1,9 +1,11 @@
-#include "shapes/sun.h"
+#include "render/sun.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <vector>
 #include <cmath>
 
+#include "utils/counters.h"
+
 
 Sun::Sun(float radius, glm::vec3 start_pos, float speed_)
     : radius(radius), x(start_pos[0]), y(start_pos[1]), z(start_pos[2]), speed(speed_) {
@@ -91,6 +93,7 @@ void Sun::buildVertices() {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO); // Element buffer object for indices
+    countEvent(COUNTER_GL_CREATED, 3);
 
     glBindVertexArray(VAO);
 
@@ -0,0 +1,312 @@
+#include "render/world_renderer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+
+#include "shapes/asteroid.h"
+#include "utils/profiler.h"
+
+
+WorldRenderer::WorldRenderer(GLuint sunTexture_)
+    : lightingShader("../shaders/shadow.vs", "../shaders/shadow.fs"),
+      textureShader("../shaders/texture.vs", "../shaders/texture.fs"),
+      brightShader("../shaders/1.colors.vs", "../shaders/1.colors.fs"),
+      sunTexture(sunTexture_) {
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+
+    appendPyramid(1.0f, vertices, indices);
+    pyramid = uploadMesh(vertices, indices, false);
+
+    vertices.clear();
+    indices.clear();
+    appendSphere(1.0f, glm::vec3(0.0f), vertices, indices);
+    sphere = uploadMesh(vertices, indices, true);
+}
+
+WorldRenderer::~WorldRenderer() {
+    destroyMesh(pyramid);
+    destroyMesh(sphere);
+    destroyMesh(stars);
+    destroyMesh(asteroid_model);
+    for (auto& [obstacle, mesh] : obstacle_meshes) {
+        destroyMesh(mesh);
+    }
+    for (auto& [radius, mesh] : planet_meshes) {
+        destroyMesh(mesh);
+    }
+}
+
+void WorldRenderer::setAsteroidModel(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices,
+        const std::vector<MeshLod>& lods) {
+    destroyMesh(asteroid_model);
+    asteroid_model = uploadMesh(vertices, indices, true);
+    asteroid_lods = lods;
+}
+
+void WorldRenderer::forgetEvicted(const World& world) {
+    // Their addresses may be reused by new obstacles
+    for (const Obstacle* obstacle : world.evicted_obstacles) {
+        auto it = obstacle_meshes.find(obstacle);
+        if (it != obstacle_meshes.end()) {
+            destroyMesh(it->second);
+            obstacle_meshes.erase(it);
+        }
+    }
+}
+
+void WorldRenderer::draw(const World& world, const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos) {
+    PROFILE_ZONE("WorldRenderer::draw");
+    gpu_timer.beginFrame();
+
+    // Chunks evicted by the last step
+    forgetEvicted(world);
+    glm::mat4 model = glm::mat4(1.0f);
+
+    brightShader.use();
+    brightShader.setMat4("model", model);
+    brightShader.setMat4("projection", projection);
+    brightShader.setMat4("view", view);
+    brightShader.setVec3("lightColor",  1.0f, 1.0f, 1.0f);
+
+    drawBoids(world);
+    drawCollectibles(world);
+    drawStars(world);
+
+    textureShader.use();
+    textureShader.setMat4("view", view);
+    textureShader.setMat4("projection", projection);
+
+    lightingShader.use();
+    lightingShader.setMat4("model", model);
+    lightingShader.setMat4("projection", projection);
+    lightingShader.setMat4("view", view);
+    lightingShader.setVec3("cameraPos", cameraPos);
+    lightingShader.setVec3("objectColor", 0.0f, 1.0f, 1.0f);
+    if (!world.planets.empty())
+        lightingShader.setVec3("lightPos", world.planets[0].getPos());
+    lightingShader.setVec3("lightColor",  1.0f, 1.0f, 0.75f);
+
+    // Projection scale at distance 1 in pixels, what a world unit covers on screen
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float pixelsPerUnit = projection[1][1] * viewport[3] * 0.5f;
+    drawObstacles(world, cameraPos, pixelsPerUnit);
+    drawSun(world);
+    drawPlanets(world);
+    drawPlayer(world);
+}
+
+void WorldRenderer::drawBoids(const World& world) {
+    PROFILE_ZONE("WorldRenderer::drawBoids");
+    GpuPass gpu(gpu_timer, GPU_PASS_BOIDS);
+    glm::mat4 scale = glm::mat4(1.0f);
+    for (const auto& [cell, boids] : world.boid_map) {
+        for (const Boid& boid : boids) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), boid.getPos())
+                * pyramidOrientation(boid.getDirection())
+                * glm::scale(scale, glm::vec3(boid.getSize()));
+            brightShader.setMat4("model", model);
+            brightShader.setVec3("objectColor", boid.getColor());
+            drawMesh(pyramid);
+        }
+    }
+    brightShader.setMat4("model", glm::mat4(1.0f));
+}
+
+void WorldRenderer::drawCollectibles(const World& world) {
+    PROFILE_ZONE("WorldRenderer::drawCollectibles");
+    GpuPass gpu(gpu_timer, GPU_PASS_COLLECTIBLES);
+    for (const Collectible& c : world.collectibles) {
+        if (c.gone)
+            continue;
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), c.getPos()), glm::vec3(c.getRadius()));
+        brightShader.setMat4("model", model);
+        brightShader.setVec3("objectColor", c.getBenefitColor());
+        drawMesh(sphere);
+    }
+    brightShader.setMat4("model", glm::mat4(1.0f));
+}
+
+void WorldRenderer::drawStars(const World& world) {
+    PROFILE_ZONE("WorldRenderer::drawStars");
+    GpuPass gpu(gpu_timer, GPU_PASS_STARS);
+    const std::vector<glm::vec3>& positions = world.space.getStars();
+    if (starVersion != world.space.getVersion()) {
+        // Stars only change when chunks stream in or out, merge them all into one mesh
+        std::vector<GLfloat> vertices;
+        std::vector<GLuint> indices;
+        for (const glm::vec3& star : positions) {
+            appendSphere(0.1f, star, vertices, indices);
+        }
+        destroyMesh(stars);
+        stars = uploadMesh(vertices, indices, true);
+        starVersion = world.space.getVersion();
+    }
+    brightShader.setVec3("objectColor", glm::vec3(1.0f,1.0f,1.0f));
+    drawMesh(stars);
+}
+
+const Mesh& WorldRenderer::obstacleMesh(const Obstacle* obstacle, uint64_t seed) {
+    auto it = obstacle_meshes.find(obstacle);
+    if (it != obstacle_meshes.end())
+        return it->second;
+
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    if (obstacle->getKind() == OBSTACLE_ASTEROID) {
+        const Asteroid* asteroid = static_cast<const Asteroid*>(obstacle);
+        Rng rng(seed, RNG_ASTEROID_MESH, asteroid->getId());
+        appendAsteroid(asteroid->getRadius(), rng, vertices, indices);
+    } else {
+        appendBox(obstacle->getWidth(), obstacle->getHeight(), obstacle->getDepth(), vertices, indices);
+    }
+    return obstacle_meshes[obstacle] = uploadMesh(vertices, indices, true);
+}
+
+void WorldRenderer::drawObstacles(const World& world, glm::vec3 cameraPos, float pixelsPerUnit) {
+    PROFILE_ZONE("WorldRenderer::drawObstacles");
+    GpuPass gpu(gpu_timer, GPU_PASS_OBSTACLES);
+    for (const auto& [cell, obstacles] : world.box_map) {
+        for (const Obstacle* obstacle : obstacles) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), obstacle->getPos());
+            if (obstacle->getKind() == OBSTACLE_ASTEROID && asteroid_model.VAO != 0) {
+                float radius = static_cast<const Asteroid*>(obstacle)->getRadius();
+                lightingShader.setVec3("objectColor", glm::vec3(0.5f,0.5f,0.5f));
+                lightingShader.setMat4("model", glm::scale(model, glm::vec3(radius)));
+                // Errors are in model units, the model is scaled by radius
+                const MeshLod& lod = asteroid_lods[selectMeshLod(asteroid_lods,
+                    glm::distance(cameraPos, obstacle->getPos()) / radius, pixelsPerUnit, MESH_LOD_MAX_PIXELS)];
+                drawMeshRange(asteroid_model, lod.first_index, lod.index_count);
+                continue;
+            }
+            if (obstacle->getKind() == OBSTACLE_ASTEROID) {
+                lightingShader.setVec3("objectColor", glm::vec3(0.5f,0.5f,0.5f));
+            } else {
+                lightingShader.setVec3("objectColor", static_cast<const Box*>(obstacle)->getColor());
+            }
+            lightingShader.setMat4("model", model);
+            drawMesh(obstacleMesh(obstacle, world.config.seed));
+        }
+    }
+    lightingShader.setMat4("model", glm::mat4(1.0f));
+}
+
+const Mesh& WorldRenderer::planetMesh(float radius) {
+    auto it = planet_meshes.find(radius);
+    if (it != planet_meshes.end())
+        return it->second;
+
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    appendSphere(radius, glm::vec3(0.0f), vertices, indices);
+    return planet_meshes[radius] = uploadMesh(vertices, indices, true);
+}
+
+void WorldRenderer::drawSun(const World& world) {
+    PROFILE_ZONE("WorldRenderer::drawSun");
+    GpuPass gpu(gpu_timer, GPU_PASS_SUN);
+    // The first planet is the sun, it also gets the textured pass
+    if (world.planets.empty())
+        return;
+    const Planet& sun = world.planets[0];
+    textureShader.use();
+    textureShader.setMat4("model", glm::translate(glm::mat4(1.0f), sun.getPos()));
+    glBindTexture(GL_TEXTURE_2D, sunTexture);
+    drawMesh(planetMesh(sun.radius));
+    textureShader.setMat4("model", glm::mat4(1.0f));
+}
+
+void WorldRenderer::drawPlanets(const World& world) {
+    PROFILE_ZONE("WorldRenderer::drawPlanets");
+    GpuPass gpu(gpu_timer, GPU_PASS_PLANETS);
+    lightingShader.use();
+    lightingShader.setVec3("objectColor", 0.5f, 0.5f, 0.5f);
+    for (const Planet& planet : world.planets) {
+        lightingShader.setMat4("model", glm::translate(glm::mat4(1.0f), planet.getPos()));
+        drawMesh(planetMesh(planet.radius));
+    }
+    lightingShader.setMat4("model", glm::mat4(1.0f));
+}
+
+void WorldRenderer::drawPlayer(const World& world) {
+    PROFILE_ZONE("WorldRenderer::drawPlayer");
+    GpuPass gpu(gpu_timer, GPU_PASS_PLAYER);
+    const Player& player = world.player;
+    brightShader.use();
+
+    // Aimer goes from red to green as the shot cools down
+    float ready = std::min(1.0f, static_cast<float>(player.getFramesSinceShot()) / player.getShotCooldown());
+    brightShader.setVec3("objectColor", glm::vec3(1.0f - ready, ready, 0.0f));
+    brightShader.setMat4("model", glm::scale(glm::translate(glm::mat4(1.0f), player.getAimerPos()), glm::vec3(0.05f)));
+    drawMesh(sphere);
+
+    brightShader.setVec3("objectColor", glm::vec3(0.2f,0.2f,0.2f));
+    brightShader.setMat4("model", glm::translate(glm::mat4(1.0f), player.getPos())
+        * pyramidOrientation(player.getDirection())
+        * glm::scale(glm::mat4(1.0f), glm::vec3(player.getSize())));
+    drawMesh(pyramid);
+
+    brightShader.setVec3("objectColor", glm::vec3(0.5f, 0.25f + player.speed * 3.00f, 0.25f + player.speed * 3.00f));
+    brightShader.setMat4("model", glm::scale(glm::translate(glm::mat4(1.0f), player.getPos()), glm::vec3(player.getSize() * 0.25f)));
+    drawMesh(sphere);
+
+    brightShader.setMat4("model", glm::mat4(1.0f));
+    for (const Bullet& b : player.getBullets()) {
+        if (b.gone)
+            continue;
+        brightShader.setVec3("objectColor", 0.0f, b.colorFade, b.colorFade);
+        const std::vector<glm::vec3>& trail = b.getTrail();
+        glBegin(GL_LINES);
+        for (size_t i = 0; i + 2 < trail.size(); i++) {
+            glVertex3fv(glm::value_ptr(trail[i]));
+            glVertex3fv(glm::value_ptr(trail[i + 1]));
+        }
+        glEnd();
+    }
+}
+
+void drawChunkBorders(const std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle*>>& box_map) {
+    // Define the half size of a cell
+    float halfCellSize = CELL_SIZE / 2.0f;
+
+    for (const auto& [cell, boxes] : box_map) {
+        int cellX, cellY, cellZ;
+        std::tie(cellX, cellY, cellZ) = cell;
+
+        // Calculate the center of this cell
+        glm::vec3 center(cellX * CELL_SIZE, cellY * CELL_SIZE, cellZ * CELL_SIZE);
+
+        // Define the 8 corners of the wireframe box
+        glm::vec3 corners[8] = {
+            center + glm::vec3(-halfCellSize, -halfCellSize, -halfCellSize),
+            center + glm::vec3(halfCellSize, -halfCellSize, -halfCellSize),
+            center + glm::vec3(halfCellSize, halfCellSize, -halfCellSize),
+            center + glm::vec3(-halfCellSize, halfCellSize, -halfCellSize),
+            center + glm::vec3(-halfCellSize, -halfCellSize, halfCellSize),
+            center + glm::vec3(halfCellSize, -halfCellSize, halfCellSize),
+            center + glm::vec3(halfCellSize, halfCellSize, halfCellSize),
+            center + glm::vec3(-halfCellSize, halfCellSize, halfCellSize),
+        };
+
+        // Set color for the cell borders (e.g., light gray)
+        glColor3f(0.7f, 0.7f, 0.7f);
+
+        // Draw edges of the cube
+        glBegin(GL_LINES);
+        for (int i = 0; i < 4; ++i) {
+            // Bottom square
+            glVertex3fv(&corners[i].x);
+            glVertex3fv(&corners[(i + 1) % 4].x);
+
+            // Top square
+            glVertex3fv(&corners[i + 4].x);
+            glVertex3fv(&corners[(i + 1) % 4 + 4].x);
+
+            // Vertical lines connecting top and bottom squares
+            glVertex3fv(&corners[i].x);
+            glVertex3fv(&corners[i + 4].x);
+        }
+        glEnd();
+    }
+}
@@ -1,22 +1,18 @@
 #include "shapes/boid.h"
 #include <algorithm>
-#include <glm/gtx/quaternion.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
+#include "utils/random.h"
 #include "utils/generation.h"
+#include "algorithm/sdf.h"
+#include "utils/counters.h"
+#include "algorithm/visibility.h"
+#include "algorithm/sensing.h"
 
+Boid::Boid(long int frame, glm::vec3 start_pos, unsigned long id_, uint64_t seed) : id(id_) {
 
-Boid::Boid(long int frame, glm::vec3 start_pos){
-
-
-    directions = directions_from_view_angle(180.0f);
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> colorDist(0.0f, 1.0f);
-
-    boidR = colorDist(gen);
-    boidG = colorDist(gen);
-    boidB = colorDist(gen);
+    Rng rng(seed, RNG_BOID_COLOR, id);
+    boidR = rng.uniform();
+    boidG = rng.uniform();
+    boidB = rng.uniform();
 
     // Increasing aggressiveness over time
     float aggressionFactor = 1.0f + (frame / 10000.0f); // Scales up with frame count
@@ -29,140 +25,142 @@ Boid::Boid(long int frame, glm::vec3 start_pos){
     boidRepelForce *= aggressionFactor;
 
     position = start_pos;
-
-    buildVertices();
+    lastSensedPos = start_pos;
 }
 
 bool Boid::contains(glm::vec3 point) const {
   return glm::distance(point, position) < 0.1f;
 }
 
-glm::vec3 Boid::rotateVertex(const glm::vec3& vertex, const glm::vec3& direction) {
-    // If the direction is valid (non-zero)
-    if (glm::length(direction) > 0.0f) {
-        glm::vec3 forward = glm::normalize(direction);  // Normalize the direction vector
-        glm::vec3 up(0.0f, 1.0f, 0.0f);  // World up vector
-
-        // Compute right and adjusted up vectors to create the correct orientation
-        glm::vec3 right = glm::normalize(glm::cross(up, forward));  // Right vector
-        glm::vec3 adjustedUp = glm::cross(forward, right);  // Adjusted up vector
-
-        // Construct the rotation matrix to align with the movement direction
-        glm::mat4 rotationMatrix = glm::mat4(1.0f);
-        rotationMatrix[0] = glm::vec4(right, 0.0f);      // Right vector
-        rotationMatrix[1] = glm::vec4(adjustedUp, 0.0f); // Adjusted up vector
-        rotationMatrix[2] = glm::vec4(forward, 0.0f);    // Forward vector
+bool Boid::act(long int frame, glm::vec3 goal_pos, const DistanceField& field, VisibilityCache& visibility,
+        SensingScheduler& sensing, glm::vec3 flock_center, std::vector<Boid>& boids) {
+    if (dead) {
+      return false;
+    }
 
-        // Apply the 90-degree rotation by rotating around the right axis (for example)
-        glm::mat4 rotation90 = glm::mat4(1.0f);
+    // A refresh costs one neighbor pair per other boid in the cell and one field sample
+    bool refresh = sensing.shouldRefresh(frame - lastSensedFrame,
+        glm::distance(position, lastSensedPos), sensedObstacleDistance, boids.size());
 
-        // Rotate by 90 degrees around the right vector
-        float angle = glm::radians(90.0f);  // 90 degrees in radians
-        rotation90 = glm::rotate(rotation90, angle, right);  // Rotate by 90 degrees
+    if (refresh) {
+      senseNeighbors(boids);
+    }
+    if (glm::length(sensedSeparation) > 0.0f) {
+      applyForce(sensedSeparation, glm::length(sensedSeparation));
+    }
 
-        // Combine the 90-degree rotation with the original rotation
-        glm::mat4 combinedRotation = rotation90 * rotationMatrix;
+    glm::vec3 flock_center_direction = glm::normalize(flock_center - position);
+    applyForce(flock_center_direction, flockAttraction);
 
-        // Apply the combined rotation to the vertex
-        glm::vec4 rotatedVertex = combinedRotation * glm::vec4(vertex, 1.0f);
-        return glm::vec3(rotatedVertex);
+    if(glm::distance(goal_pos, position) < maxDetectionRange &&
+        visibility.visible(positionToCell(position))){
+      applyForce(glm::normalize(goal_pos - position), goalAttraction);
     }
+    position += direction * speed;
+    speed *= 0.92;
 
-    // Return the original vertex if no direction is provided
-    return vertex;
+    if (refresh) {
+      senseObstacles(field);
+      lastSensedFrame = frame;
+      lastSensedPos = position;
+    } else if (field.sample(position) <= 0.1f) {
+      // Boids not refreshing still test for a hit, one sample is cheap next to the neighbor pairs
+      dead = true;
+    }
+    applySensedObstacleForce();
+    return true;
 }
 
-void Boid::buildVertices() {
-    float halfSize = size / 2.0f;
-
-    // Define the base vertices (before rotation)
-    std::vector<glm::vec3> unrotatedVertices = {
-        {-halfSize, 0.0f, -halfSize},   // Base - bottom left
-        { halfSize, 0.0f, -halfSize},   // Base - bottom right
-        { halfSize, 0.0f,  halfSize},   // Base - top right
-        {-halfSize, 0.0f,  halfSize},   // Base - top left
-        { 0.0f, size,  0.0f}            // Apex
-    };
-
-    // Clear previous vertices
-    vertices.clear();
-
-    // Rotate and translate the vertices, and push them to the vertices vector
-    for (const auto& vertex : unrotatedVertices) {
-        glm::vec3 rotatedVertex = rotateVertex(vertex, direction);  // Apply rotation
-        rotatedVertex += position; // Translate the vertex based on boid's position
-        
-        // Add the rotated and translated vertex to the vertices vector
-        vertices.push_back(rotatedVertex.x);
-        vertices.push_back(rotatedVertex.y);
-        vertices.push_back(rotatedVertex.z);
+bool Boid::tick(long int frame, glm::vec3 goal_pos, const DistanceField& field, VisibilityCache& visibility,
+        SensingScheduler& sensing, glm::vec3 flock_center, glm::vec3 flock_heading, std::vector<Boid>& boids) {
+    lod = selectSimLod(glm::distance(goal_pos, position), lod);
+
+    switch (lod) {
+      case LOD_NEAR:
+        return act(frame, goal_pos, field, visibility, sensing, flock_center, boids);
+      case LOD_MID:
+        // Stagger the full updates by id so mid range boids don't all sense on the same tick
+        if ((frame + id) % LOD_MID_INTERVAL == 0)
+          return act(frame, goal_pos, field, visibility, sensing, flock_center, boids);
+        return coast();
+      case LOD_FAR:
+      default:
+        return drift(flock_center, flock_heading, field);
     }
+}
 
-    // Define indices for the base and sides (unchanged)
-    indices = {
-        0, 1, 2,    // Base face
-        0, 2, 3,
-        0, 1, 4,    // Side faces
-        1, 2, 4,
-        2, 3, 4,
-        3, 0, 4
-    };
-
-    // Generate OpenGL buffers
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindVertexArray(0);
+bool Boid::coast() {
+    // Extrapolate along the last sensed heading with the same damping as act
+    if (dead) {
+      return false;
+    }
+    position += direction * speed;
+    speed *= 0.92;
+    return true;
 }
 
-bool Boid::act(glm::vec3 goal_pos, std::vector<Obstacle*> obstacles, glm::vec3 flock_center, std::vector<Boid>& boids) {
+bool Boid::drift(glm::vec3 flock_center, glm::vec3 flock_heading, const DistanceField& field) {
+    // Far boids follow their cell's flock as a group: steer toward the shared center
+    // and heading instead of evaluating every neighbor pair
     if (dead) {
       return false;
     }
+    if (glm::length(flock_heading) > 0.0f) {
+      direction = glm::normalize(glm::mix(direction, glm::normalize(flock_heading), 0.1f));
+    }
+    if (glm::distance(flock_center, position) > 0.0f) {
+      applyForce(flock_center - position, flockAttraction);
+    }
+    position += direction * speed;
+    speed *= 0.92;
+    avoidObstacles(field);
+    return true;
+}
 
-    applyFlockForces(boids);
+bool Boid::driftFlock(std::vector<Boid>& boids, glm::vec3 goal_pos,
+        glm::vec3 flock_heading, const DistanceField& field) {
+    if (boids.empty())
+      return false;
 
-    glm::vec3 flock_center_direction = glm::normalize(flock_center - position);
-    applyForce(flock_center_direction, flockAttraction);
+    // The plain mean, not getCenter's: its bias toward the origin puts the
+    // center units away from a far cell and the radius past any clearance
+    glm::vec3 sum(0.0f);
+    float speedSum = 0.0f;
+    bool allFar = true;
+    for (const Boid& boid : boids) {
+      if (boid.dead)
+        return false;
+      sum += boid.position;
+      speedSum += boid.speed;
+      allFar = allFar && boid.lod == LOD_FAR;
+    }
+    glm::vec3 flock_center = sum / float(boids.size());
+    // The flock's extent, its members all lie within radius of the center
+    float radius = 0.0f;
+    for (const Boid& boid : boids) {
+      radius = std::max(radius, glm::distance(boid.position, flock_center));
+    }
+    // Every member has to be far, with the same hysteresis selectSimLod uses
+    float closest = glm::distance(goal_pos, flock_center) - radius;
+    if (closest < (allFar ? LOD_FAR_RANGE - LOD_HYSTERESIS : LOD_FAR_RANGE))
+      return false;
+    // One sample bounds every member's obstacle distance, flocks that could
+    // feel an obstacle or hit one are left to per-boid drift
+    if (field.sample(flock_center) - radius < LOD_FLOCK_CLEARANCE)
+      return false;
 
-    if(glm::distance(goal_pos, position) < maxDetectionRange){
-      glm::vec3 goal_direction = glm::normalize(goal_pos - position);
-      // TODO: improve this line of sight code
-      glm::vec3 rayPos = position;
-      float maxRayLength = glm::distance(goal_pos, position);
-      float rayStepSize = maxRayLength / 30;
-      float clear = true;
-      if(obstacles.size() > 0){
-        for(int i = 0; i < 30; i++){
-          rayPos += goal_direction * rayStepSize;
-          for(Obstacle* obs: obstacles){
-            if(obs->contains(rayPos)){
-              clear = false;
-              break;
-            }
-          }
-        }
-      }
-      if(clear)
-        applyForce(goal_direction, goalAttraction);
+    // Drift for the flock as a whole: its center has no pull toward itself,
+    // so it keeps the mean heading and speed and damps like every boid
+    glm::vec3 heading = flock_heading;
+    float speed = speedSum / boids.size();
+    glm::vec3 step = heading * speed;
+    for (Boid& boid : boids) {
+      if (glm::length(heading) > 0.0f)
+        boid.direction = heading;
+      boid.position += step;
+      boid.speed = speed * 0.92f;
+      boid.lod = LOD_FAR;
     }
-    position += direction * speed;
-    speed *= 0.92;
-    avoidObstacles(obstacles, boids);
-    buildVertices();
     return true;
 }
 
@@ -177,17 +175,6 @@ void Boid::applyForce(glm::vec3 force_direction, float strength) {
     speed = glm::clamp(speed, 0.0f, maxBoidSpeed);
 }
 
-void Boid::draw(Shader& shader) const {
-    shader.setVec3("objectColor", boidR, boidG, boidB);
-    glBindVertexArray(VAO);
-
-    // Apply the model matrix to the shader program
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0); // Draw using indices
-    glBindVertexArray(0);
-
-}
-
-
 std::vector<glm::vec3> Boid::directions_from_view_angle(float angle){
     std::vector<glm::vec3> directions = {
         glm::vec3(1.0f, 0.0f, 0.0f),  // Right
@@ -240,59 +227,42 @@ std::vector<glm::vec3> Boid::directions_from_view_angle(float angle){
     return kept_dirs;
 }
 
-void Boid::avoidObstacles(std::vector<Obstacle*> boxes, std::vector<Boid> boids){
-
-  for(auto dir : directions){
-    glm::vec3 rotatedDir = glm::normalize(direction - dir);
-    glm::vec3 rayPosition = position;
-
-    for (float distance = 0.0f; distance <= rayMaxLength; distance += rayStepSize) {
-        rayPosition += rotatedDir;
+void Boid::avoidObstacles(const DistanceField& field){
+  senseObstacles(field);
+  applySensedObstacleForce();
+}
 
-        auto collisionObstacle = std::find_if(boxes.begin(), boxes.end(), [&](const Obstacle* box) {
-            return box->contains(rayPosition);
-        });
+void Boid::senseObstacles(const DistanceField& field){
+  // One field lookup gives the distance to the nearest obstacle and the direction away from it
+  sensedObstacleDistance = field.sample(position, &sensedObstacleDirection);
 
-        if (collisionObstacle != boxes.end()) {
-            float rayLen = glm::distance(rayPosition, position);
-            if(rayLen <= 0.1f){
-              dead = true;
-            }
-            applyForce(- glm::normalize(rayPosition - position) 
-                ,obstacleRepelForce / (rayLen * obstacleRepelDecay));
-            break;
-        }
-    }
+  if(sensedObstacleDistance >= field.getBand()){
+    sensedObstacleDirection = glm::vec3(0.0f);
+  }
+  if(sensedObstacleDistance <= 0.1f){
+    dead = true;
   }
-
 }
 
-void Boid::applyFlockForces(std::vector<Boid>& boids) {
-    glm::vec3 averageDirection(0.1, 0.0f, 0.0f);
-    int neighborCount = 0;
+void Boid::applySensedObstacleForce(){
+  if(glm::length(sensedObstacleDirection) == 0.0f)
+    return;
 
-    for (Boid& boid : boids) {
-        if(&boid != this){
-          applyForce(-glm::normalize(boid.getPos() - position) 
-            ,boidRepelForce / (glm::distance(boid.getPos(), position) * boidRepelDecay));
-          averageDirection += boid.getDirection();
-          neighborCount++;
-        }
-    }
-
-    float alignmentStrength = 0.0f;
-
-    if (neighborCount > 0) {
-        averageDirection /= static_cast<float>(neighborCount);
-        averageDirection = glm::normalize(averageDirection);
-        applyForce(-averageDirection, alignmentStrength);
-    }
+  applyForce(sensedObstacleDirection,
+      obstacleRepelForce / (std::max(sensedObstacleDistance, 0.1f) * obstacleRepelDecay));
 }
 
-void Boid::drawLine(glm::vec3 start, glm::vec3 end){
-    glBegin(GL_LINES);
-    glVertex3fv(glm::value_ptr(start));
-    glVertex3fv(glm::value_ptr(end));
-    glEnd();
+void Boid::senseNeighbors(const std::vector<Boid>& boids) {
+    // Sum the separation from every other boid in the cell into one cached force
+    sensedSeparation = glm::vec3(0.0f);
+    if (!boids.empty())
+      countEvent(COUNTER_NEIGHBOR_PAIRS, boids.size() - 1);
+
+    for (const Boid& boid : boids) {
+        float boidDistance = glm::distance(boid.getPos(), position);
+        if(&boid != this && boidDistance > 0.0f){
+          sensedSeparation += -(boid.getPos() - position) / boidDistance
+            * (boidRepelForce / (boidDistance * boidRepelDecay));
+        }
+    }
 }
-
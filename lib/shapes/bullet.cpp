@@ -1,5 +1,8 @@
 #include "shapes/bullet.h"
-#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+#include "utils/profiler.h"
+#include "utils/counters.h"
 
 #define CELL_SIZE 2.0f
 
@@ -21,12 +24,12 @@ Bullet::Bullet(glm::vec3 startPos, glm::vec3 cameraFront,
     : position(startPos), 
     direction(glm::normalize(cameraFront)), 
     maxDistance(shotRange), strength(shotAccuracy) {
+      PROFILE_ZONE("Bullet");
       int distance = 0;
       while (distance < maxDistance && !gone) {
         trail.push_back(position);
         std::tuple<int,int,int> currentCell = positionToCell(position);
-        std::vector<Boid>& boids = boid_map[currentCell];
-        std::vector<std::tuple<int, int, int>> cellOffsets = {
+        static const std::tuple<int, int, int> cellOffsets[] = {
             {0, 0, 0}, {1, 0, 0}, {-1, 0, 0},
             {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
             {1, 1, 0}, {-1, -1, 0}, {1, 0, 1}, {-1, 0, -1},
@@ -35,16 +38,28 @@ Bullet::Bullet(glm::vec3 startPos, glm::vec3 cameraFront,
             {1, 1, 1}, {-1, -1, -1}, {-1, 1, 1}, {1, -1, 1},
             {1, 1, -1}, {-1, 1, -1}, {1, -1, -1}
         };
-        for(int i = 0; i < cellOffsets.size() && boids.size() == 0; i++){
+        // The current cell, or the first non-empty neighbor cell. Looked up
+        // with find so cells the bullet passes through are not inserted.
+        std::vector<Boid>* boids = nullptr;
+        for(const std::tuple<int, int, int>& offset : cellOffsets){
           std::tuple<int, int, int> adjacentCell = {
-                std::get<0>(currentCell) + std::get<0>(cellOffsets[i]),
-                std::get<1>(currentCell) + std::get<1>(cellOffsets[i]),
-                std::get<2>(currentCell) + std::get<2>(cellOffsets[i])
+                std::get<0>(currentCell) + std::get<0>(offset),
+                std::get<1>(currentCell) + std::get<1>(offset),
+                std::get<2>(currentCell) + std::get<2>(offset)
           };
-          boids = boid_map[adjacentCell];
+          auto it = boid_map.find(adjacentCell);
+          if(it != boid_map.end() && !it->second.empty()){
+            boids = &it->second;
+            break;
+          }
+        }
+        if(boids == nullptr){
+          position += direction;
+          distance++;
+          continue;
         }
 
-        for (Boid& boid : boids) {
+        for (Boid& boid : *boids) {
             if (glm::distance(boid.getPos(), position) < 0.01f){
                 boid.explode();
                 gone = true;
@@ -60,26 +75,16 @@ Bullet::Bullet(glm::vec3 startPos, glm::vec3 cameraFront,
         position += direction;
         distance++;
     }
+    countEvent(COUNTER_BULLET_STEPS, distance);
 }
 
-void Bullet::draw(Shader& shader){
+void Bullet::update(){
     if (!gone) {
         colorFade -= 0.01f;
     }
     if(colorFade <= 0.0f){
       gone = true;
     }
-    shader.setVec3("objectColor", 0.0f, colorFade, colorFade);
-    for(int i = 0; i < trail.size() - 2; i++){
-      drawLine(trail[i], trail[i+ 1]);
-    }
-}
-
-void Bullet::drawLine(glm::vec3 start, glm::vec3 end){
-    glBegin(GL_LINES);
-    glVertex3fv(glm::value_ptr(start));
-    glVertex3fv(glm::value_ptr(end));
-    glEnd();
 }
 
 std::tuple<int, int, int> Bullet::positionToCell(const glm::vec3& pos) {
@@ -0,0 +1,196 @@
+#include "utils/asset_archive.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "utils/profiler.h"
+
+
+static_assert(sizeof(AssetArchiveHeader) == 24, "header layout is part of the file format");
+static_assert(sizeof(AssetEntry) == 32, "entry layout is part of the file format");
+
+static size_t alignUp(size_t offset) {
+    return (offset + ASSET_ALIGNMENT - 1) & ~size_t(ASSET_ALIGNMENT - 1);
+}
+
+uint64_t assetHash(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool AssetArchive::open(const std::string& path) {
+    close();
+    error.clear();
+    if (!file.open(path)) {
+        error = file.getError();
+        return false;
+    }
+    size_t size = file.size();
+    if (size < sizeof(AssetArchiveHeader)) {
+        error = path + " is too small to be an asset archive";
+        close();
+        return false;
+    }
+    header = reinterpret_cast<const AssetArchiveHeader*>(file.data());
+    entries = reinterpret_cast<const AssetEntry*>(file.data() + sizeof(AssetArchiveHeader));
+    size_t tableEnd = sizeof(AssetArchiveHeader) + size_t(header->entry_count) * sizeof(AssetEntry);
+    names = file.data() + tableEnd;
+
+    if (header->magic != ASSET_ARCHIVE_MAGIC) {
+        error = path + " is not an asset archive";
+    } else if (header->version != ASSET_ARCHIVE_VERSION) {
+        error = path + " is asset archive version " + std::to_string(header->version)
+            + ", expected " + std::to_string(ASSET_ARCHIVE_VERSION);
+    } else if (header->file_size != size || tableEnd + header->names_size > size) {
+        error = path + " is truncated";
+    } else {
+        for (uint32_t i = 0; i < header->entry_count; i++) {
+            const AssetEntry& entry = entries[i];
+            if (size_t(entry.name_offset) + entry.name_length > header->names_size
+                    || entry.offset % ASSET_ALIGNMENT != 0 || entry.offset + entry.size > size
+                    || (i > 0 && name(i - 1) >= name(i))) {
+                error = path + " has a corrupt table of contents";
+                break;
+            }
+        }
+    }
+    if (!error.empty()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetArchive::close() {
+    file.close();
+    header = nullptr;
+    entries = nullptr;
+    names = nullptr;
+}
+
+std::string_view AssetArchive::name(uint32_t i) const {
+    return std::string_view(names + entries[i].name_offset, entries[i].name_length);
+}
+
+AssetView AssetArchive::find(std::string_view wanted) const {
+    AssetView view;
+    if (!isOpen())
+        return view;
+    // Entries are sorted by name
+    uint32_t lo = 0, hi = header->entry_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (name(mid) < wanted)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == header->entry_count || name(lo) != wanted)
+        return view;
+    const AssetEntry& entry = entries[lo];
+    view.data = file.data() + entry.offset;
+    view.size = entry.size;
+    view.hash = entry.hash;
+    return view;
+}
+
+bool AssetArchive::verify(std::string& error) const {
+    PROFILE_ZONE("AssetArchive::verify");
+    for (uint32_t i = 0; i < count(); i++) {
+        const AssetEntry& entry = entries[i];
+        if (assetHash(file.data() + entry.offset, entry.size) != entry.hash) {
+            error = std::string(name(i)) + " does not match its hash";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool writeAssetArchive(const std::string& path, const std::string& root, std::vector<std::string> names,
+        std::string& error) {
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    std::vector<AssetEntry> entries(names.size());
+    std::string nameTable;
+    for (size_t i = 0; i < names.size(); i++) {
+        entries[i].name_offset = nameTable.size();
+        entries[i].name_length = names[i].size();
+        nameTable += names[i];
+    }
+
+    std::vector<std::string> contents(names.size());
+    size_t offset = alignUp(sizeof(AssetArchiveHeader) + entries.size() * sizeof(AssetEntry) + nameTable.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        std::ifstream in(root + "/" + names[i], std::ios::binary);
+        if (!in) {
+            error = "could not read " + root + "/" + names[i];
+            return false;
+        }
+        contents[i].assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        entries[i].offset = offset;
+        entries[i].size = contents[i].size();
+        entries[i].hash = assetHash(contents[i].data(), contents[i].size());
+        offset = alignUp(offset + contents[i].size());
+    }
+
+    AssetArchiveHeader header = {};
+    header.magic = ASSET_ARCHIVE_MAGIC;
+    header.version = ASSET_ARCHIVE_VERSION;
+    header.entry_count = entries.size();
+    header.names_size = nameTable.size();
+    header.file_size = offset;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "could not open " + path + " for writing";
+        return false;
+    }
+    auto pad = [&]() {
+        static const char zeros[ASSET_ALIGNMENT] = {};
+        out.write(zeros, alignUp(out.tellp()) - size_t(out.tellp()));
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetEntry));
+    out.write(nameTable.data(), nameTable.size());
+    pad();
+    for (const std::string& content : contents) {
+        out.write(content.data(), content.size());
+        pad();
+    }
+    if (!out) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+AssetArchive& assetArchive() {
+    static AssetArchive archive;
+    return archive;
+}
+
+AssetView findAsset(std::string_view path) {
+    while (path.substr(0, 3) == "../" || path.substr(0, 2) == "./") {
+        path.remove_prefix(path[0] == '.' && path[1] == '.' ? 3 : 2);
+    }
+    return assetArchive().find(path);
+}
+
+AssetView readAsset(const std::string& path, std::string& storage) {
+    AssetView view = findAsset(path);
+    if (view)
+        return view;
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return view;
+    storage.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    view.data = storage.data();
+    view.size = storage.size();
+    view.hash = assetHash(storage.data(), storage.size());
+    return view;
+}
@@ -0,0 +1,235 @@
+#include "utils/chunk_store.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include "shapes/asteroid.h"
+#include "utils/chunks.h"
+
+
+static_assert(sizeof(ChunkStoreHeader) == 56, "header layout is part of the file format");
+static_assert(sizeof(ChunkIndexEntry) == 48, "index layout is part of the file format");
+static_assert(sizeof(StoredAsteroid) == 24, "asteroid layout is part of the file format");
+static_assert(sizeof(StoredBox) == 36, "box layout is part of the file format");
+
+static size_t alignUp(size_t offset) {
+    return (offset + 15) & ~size_t(15);
+}
+
+// Byte offsets of the sections inside a chunk, asteroids first for their 8 byte ids
+static size_t boxesOffset(const ChunkIndexEntry& entry) {
+    return entry.asteroid_count * sizeof(StoredAsteroid);
+}
+static size_t starsOffset(const ChunkIndexEntry& entry) {
+    return boxesOffset(entry) + entry.box_count * sizeof(StoredBox);
+}
+static size_t bricksOffset(const ChunkIndexEntry& entry) {
+    return alignUp(starsOffset(entry) + entry.star_count * sizeof(StoredStar));
+}
+static size_t chunkBytes(const ChunkIndexEntry& entry) {
+    return bricksOffset(entry) + entry.brick_count * sizeof(StoredBrick);
+}
+
+static bool keyLess(const ChunkIndexEntry& a, const std::tuple<int,int,int>& key) {
+    return std::make_tuple(a.x, a.y, a.z) < key;
+}
+
+ChunkStore::~ChunkStore() {
+    close();
+}
+
+bool ChunkStore::open(const std::string& path) {
+    close();
+    error.clear();
+    // Chunks are visited in whatever order the player flies, read ahead is wasted
+    if (!file.open(path, true)) {
+        error = file.getError();
+        return false;
+    }
+    size_t size = file.size();
+    if (size < sizeof(ChunkStoreHeader)) {
+        error = path + " is too small to be a chunk store";
+        close();
+        return false;
+    }
+
+    header = reinterpret_cast<const ChunkStoreHeader*>(file.data());
+    index = reinterpret_cast<const ChunkIndexEntry*>(file.data() + sizeof(ChunkStoreHeader));
+    if (header->magic != CHUNK_STORE_MAGIC) {
+        error = path + " is not a chunk store";
+    } else if (header->version != CHUNK_STORE_VERSION) {
+        error = path + " is chunk store version " + std::to_string(header->version)
+            + ", expected " + std::to_string(CHUNK_STORE_VERSION);
+    } else if (header->file_size != size
+            || sizeof(ChunkStoreHeader) + size_t(header->chunk_count) * sizeof(ChunkIndexEntry) > size) {
+        error = path + " is truncated";
+    } else {
+        for (uint32_t i = 0; i < header->chunk_count; i++) {
+            const ChunkIndexEntry& entry = index[i];
+            if (entry.offset % 16 != 0 || entry.bytes != chunkBytes(entry) || entry.offset + entry.bytes > size) {
+                error = path + " has a corrupt chunk index";
+                break;
+            }
+        }
+    }
+    if (!error.empty()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ChunkStore::close() {
+    file.close();
+    header = nullptr;
+    index = nullptr;
+}
+
+void ChunkStore::reject(const std::string& reason) {
+    close();
+    error = reason;
+}
+
+const ChunkIndexEntry* ChunkStore::find(const std::tuple<int,int,int>& key) const {
+    if (!isOpen())
+        return nullptr;
+    const ChunkIndexEntry* end = index + header->chunk_count;
+    const ChunkIndexEntry* found = std::lower_bound(index, end, key, keyLess);
+    if (found == end || std::make_tuple(found->x, found->y, found->z) != key)
+        return nullptr;
+    return found;
+}
+
+const char* ChunkStore::section(const ChunkIndexEntry& entry, size_t skip) const {
+    return file.data() + entry.offset + skip;
+}
+
+const StoredAsteroid* ChunkStore::asteroids(const ChunkIndexEntry& entry) const {
+    return reinterpret_cast<const StoredAsteroid*>(section(entry, 0));
+}
+
+const StoredBox* ChunkStore::boxes(const ChunkIndexEntry& entry) const {
+    return reinterpret_cast<const StoredBox*>(section(entry, boxesOffset(entry)));
+}
+
+const StoredStar* ChunkStore::stars(const ChunkIndexEntry& entry) const {
+    return reinterpret_cast<const StoredStar*>(section(entry, starsOffset(entry)));
+}
+
+const StoredBrick* ChunkStore::bricks(const ChunkIndexEntry& entry) const {
+    return reinterpret_cast<const StoredBrick*>(section(entry, bricksOffset(entry)));
+}
+
+bool ChunkStore::bricksMatch(const DistanceField& field) const {
+    return isOpen()
+        && header->brick_size == SDF_BRICK_SIZE
+        && header->voxel_size == field.getVoxelSize()
+        && header->band == field.getBand();
+}
+
+bool writeChunkStore(const std::string& path, uint64_t seed, float chunkSize,
+    const std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+    const std::vector<glm::vec3>& stars,
+    const DistanceField& field,
+    std::string& error) {
+    // Everything bucketed by chunk, the ordered map gives the index order
+    struct Bucket {
+        std::vector<StoredAsteroid> asteroids;
+        std::vector<StoredBox> boxes;
+        std::vector<StoredStar> stars;
+        std::vector<BakedBrick> bricks;
+    };
+    std::map<std::tuple<int,int,int>, Bucket> buckets;
+
+    for (const auto& [cell, obstacles] : box_map) {
+        for (const Obstacle* obstacle : obstacles) {
+            Bucket& bucket = buckets[positionToChunk(obstacle->getPos(), chunkSize)];
+            if (obstacle->getKind() == OBSTACLE_ASTEROID) {
+                const Asteroid* asteroid = static_cast<const Asteroid*>(obstacle);
+                bucket.asteroids.push_back(StoredAsteroid{
+                    {asteroid->getX(), asteroid->getY(), asteroid->getZ()}, asteroid->getRadius(), asteroid->getId()});
+            } else {
+                glm::vec3 color = static_cast<const Box*>(obstacle)->getColor();
+                bucket.boxes.push_back(StoredBox{
+                    {obstacle->getMinX(), obstacle->getMinY(), obstacle->getMinZ()},
+                    {obstacle->getMaxX(), obstacle->getMaxY(), obstacle->getMaxZ()},
+                    {color.x, color.y, color.z}});
+            }
+        }
+    }
+    for (const glm::vec3& star : stars) {
+        buckets[positionToChunk(star, chunkSize)].stars.push_back(StoredStar{{star.x, star.y, star.z}});
+    }
+    // A brick goes with the chunk holding its origin, whichever chunks its obstacles are in
+    float brickWorldSize = field.getVoxelSize() * SDF_BRICK_SIZE;
+    for (const BakedBrick& brick : field.bakedBricks()) {
+        glm::vec3 origin = glm::vec3(std::get<0>(brick.key), std::get<1>(brick.key), std::get<2>(brick.key)) * brickWorldSize;
+        buckets[positionToChunk(origin + glm::vec3(brickWorldSize * 0.5f), chunkSize)].bricks.push_back(brick);
+    }
+
+    std::vector<ChunkIndexEntry> index;
+    size_t offset = alignUp(sizeof(ChunkStoreHeader) + buckets.size() * sizeof(ChunkIndexEntry));
+    for (const auto& [key, bucket] : buckets) {
+        ChunkIndexEntry entry = {};
+        entry.x = std::get<0>(key);
+        entry.y = std::get<1>(key);
+        entry.z = std::get<2>(key);
+        entry.asteroid_count = bucket.asteroids.size();
+        entry.box_count = bucket.boxes.size();
+        entry.star_count = bucket.stars.size();
+        entry.brick_count = bucket.bricks.size();
+        entry.offset = offset;
+        entry.bytes = chunkBytes(entry);
+        index.push_back(entry);
+        offset = alignUp(offset + entry.bytes);
+    }
+
+    ChunkStoreHeader header = {};
+    header.magic = CHUNK_STORE_MAGIC;
+    header.version = CHUNK_STORE_VERSION;
+    header.seed = seed;
+    header.file_size = offset;
+    header.chunk_size = chunkSize;
+    header.voxel_size = field.getVoxelSize();
+    header.band = field.getBand();
+    header.brick_size = SDF_BRICK_SIZE;
+    header.chunk_count = index.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "could not open " + path + " for writing";
+        return false;
+    }
+    auto write = [&](const void* data, size_t bytes) {
+        out.write(static_cast<const char*>(data), bytes);
+    };
+    auto pad = [&]() {
+        static const char zeros[16] = {};
+        write(zeros, alignUp(out.tellp()) - size_t(out.tellp()));
+    };
+
+    write(&header, sizeof(header));
+    write(index.data(), index.size() * sizeof(ChunkIndexEntry));
+    pad();
+    for (const auto& [key, bucket] : buckets) {
+        write(bucket.asteroids.data(), bucket.asteroids.size() * sizeof(StoredAsteroid));
+        write(bucket.boxes.data(), bucket.boxes.size() * sizeof(StoredBox));
+        write(bucket.stars.data(), bucket.stars.size() * sizeof(StoredStar));
+        pad();
+        for (const BakedBrick& brick : bucket.bricks) {
+            StoredBrick stored = {};
+            stored.key[0] = std::get<0>(brick.key);
+            stored.key[1] = std::get<1>(brick.key);
+            stored.key[2] = std::get<2>(brick.key);
+            std::memcpy(stored.distances, brick.distances, sizeof(stored.distances));
+            write(&stored, sizeof(stored));
+        }
+        pad();
+    }
+    if (!out) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
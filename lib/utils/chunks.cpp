@@ -0,0 +1,481 @@
+#include "utils/chunks.h"
+#include <algorithm>
+#include <cmath>
+
+#include "shapes/asteroid.h"
+#include "utils/random.h"
+#include "utils/profiler.h"
+#include "utils/counters.h"
+
+
+chunk_key_t positionToChunk(const glm::vec3& pos, float chunkSize) {
+    return std::make_tuple(
+        static_cast<int>(std::floor(pos.x / chunkSize)),
+        static_cast<int>(std::floor(pos.y / chunkSize)),
+        static_cast<int>(std::floor(pos.z / chunkSize)));
+}
+
+// 21 bits per axis, the Rng key of everything in the chunk
+static uint64_t packChunkKey(const chunk_key_t& key) {
+    const uint64_t mask = (1u << 21) - 1;
+    return (uint64_t(uint32_t(std::get<0>(key))) & mask) << 42
+        | (uint64_t(uint32_t(std::get<1>(key))) & mask) << 21
+        | (uint64_t(uint32_t(std::get<2>(key))) & mask);
+}
+
+// Bricks the obstacle touches in a default DistanceField, by far the largest
+// part of what a loaded obstacle costs
+static size_t fieldBytes(const Obstacle* obstacle) {
+    const float brick = SDF_VOXEL_SIZE * SDF_BRICK_SIZE;
+    const size_t brickBytes = (SDF_BRICK_SIZE + 1) * (SDF_BRICK_SIZE + 1) * (SDF_BRICK_SIZE + 1) * sizeof(float);
+    auto span = [&](float lo, float hi) {
+        return size_t(std::floor((hi + SDF_BAND) / brick) - std::floor((lo - SDF_BAND) / brick) + 1);
+    };
+    return span(obstacle->getMinX(), obstacle->getMaxX())
+        * span(obstacle->getMinY(), obstacle->getMaxY())
+        * span(obstacle->getMinZ(), obstacle->getMaxZ())
+        * brickBytes;
+}
+
+static size_t estimateBytes(const Chunk& chunk) {
+    size_t bytes = sizeof(Chunk) + chunk.stars.size() * sizeof(glm::vec3) + chunk.bricks.size() * sizeof(BakedBrick);
+    for (const Obstacle* obstacle : chunk.obstacles) {
+        size_t objectBytes = obstacle->getKind() == OBSTACLE_ASTEROID ? sizeof(Asteroid) : sizeof(Box);
+        bytes += objectBytes + 2 * sizeof(Obstacle*) + fieldBytes(obstacle);
+    }
+    return bytes;
+}
+
+Chunk generateChunk(const ChunkConfig& config, uint64_t seed, const chunk_key_t& key) {
+    PROFILE_ZONE("generateChunk");
+    Chunk chunk;
+    chunk.key = key;
+
+    uint64_t id = packChunkKey(key);
+    glm::vec3 origin = glm::vec3(std::get<0>(key), std::get<1>(key), std::get<2>(key)) * config.size;
+    auto randomPos = [&](Rng& rng) {
+        return origin + glm::vec3(
+            rng.uniform(0.0f, config.size),
+            rng.uniform(0.0f, config.size),
+            rng.uniform(0.0f, config.size));
+    };
+    auto isClear = [&](const glm::vec3& pos, float radius) {
+        return glm::distance(pos, config.clearCenter) > config.clearRadius + radius;
+    };
+
+    for (int i = 0; i < config.boxes; i++) {
+        Rng rng(seed, RNG_CHUNK_BOXES, id, i);
+        float width = rng.uniform(0.5f, config.boxMaxSize);
+        float height = rng.uniform(0.5f, config.boxMaxSize);
+        float depth = rng.uniform(0.5f, config.boxMaxSize);
+        glm::vec3 pos = randomPos(rng);
+        float r = rng.uniform();
+        float g = rng.uniform();
+        float b = rng.uniform();
+        if (isClear(pos, config.boxMaxSize))
+            chunk.obstacles.push_back(new Box(width, height, depth, pos.x, pos.y, pos.z, r, g, b));
+    }
+
+    for (int i = 0; i < config.asteroids; i++) {
+        Rng rng(seed, RNG_CHUNK_ASTEROIDS, id, i);
+        float radius = rng.uniform(0.5f, 2.0f);
+        glm::vec3 pos = randomPos(rng);
+        // The id keys the asteroid's mesh, so it has to be unique across chunks too
+        if (isClear(pos, radius))
+            chunk.obstacles.push_back(new Asteroid(radius, pos, 0.0f, mix64(id) + i));
+    }
+
+    for (int i = 0; i < config.stars; i++) {
+        Rng rng(seed, RNG_CHUNK_STARS, id, i);
+        chunk.stars.push_back(randomPos(rng));
+    }
+
+    chunk.bytes = estimateBytes(chunk);
+    return chunk;
+}
+
+Chunk loadChunk(const ChunkStore& store, const chunk_key_t& key) {
+    PROFILE_ZONE("loadChunk");
+    Chunk chunk;
+    chunk.key = key;
+    const ChunkIndexEntry* entry = store.find(key);
+    if (entry == nullptr)
+        return chunk;
+
+    const StoredAsteroid* asteroids = store.asteroids(*entry);
+    for (uint32_t i = 0; i < entry->asteroid_count; i++) {
+        const StoredAsteroid& a = asteroids[i];
+        chunk.obstacles.push_back(new Asteroid(a.radius, glm::vec3(a.pos[0], a.pos[1], a.pos[2]), 0.0f, a.id));
+    }
+    const StoredBox* boxes = store.boxes(*entry);
+    for (uint32_t i = 0; i < entry->box_count; i++) {
+        const StoredBox& b = boxes[i];
+        glm::vec3 lo(b.min[0], b.min[1], b.min[2]);
+        glm::vec3 hi(b.max[0], b.max[1], b.max[2]);
+        glm::vec3 center = (lo + hi) * 0.5f;
+        chunk.obstacles.push_back(new Box(hi.z - lo.z, hi.x - lo.x, hi.y - lo.y,
+            center.x, center.y, center.z, b.color[0], b.color[1], b.color[2]));
+    }
+    const StoredStar* stars = store.stars(*entry);
+    for (uint32_t i = 0; i < entry->star_count; i++) {
+        chunk.stars.push_back(glm::vec3(stars[i].pos[0], stars[i].pos[1], stars[i].pos[2]));
+    }
+    const StoredBrick* bricks = store.bricks(*entry);
+    for (uint32_t i = 0; i < entry->brick_count; i++) {
+        chunk.bricks.push_back(BakedBrick{
+            std::make_tuple(bricks[i].key[0], bricks[i].key[1], bricks[i].key[2]), bricks[i].distances});
+    }
+
+    chunk.bytes = estimateBytes(chunk);
+    return chunk;
+}
+
+static void freeChunk(Chunk& chunk) {
+    for (Obstacle* obstacle : chunk.obstacles) {
+        delete obstacle;
+    }
+    chunk.obstacles.clear();
+}
+
+ChunkStreamer::ChunkStreamer(const ChunkConfig& config_, uint64_t seed_)
+    : config(config_), seed(seed_) {
+    // On failure chunks are generated as if no store was given
+    if (!config.storePath.empty() && store.open(config.storePath)) {
+        const ChunkStoreHeader& header = store.getHeader();
+        if (header.seed != seed) {
+            store.reject(config.storePath + " was baked from seed " + std::to_string(header.seed)
+                + ", this world uses seed " + std::to_string(seed));
+        } else {
+            // The store's chunk keys are in the chunk size it was baked with
+            config.size = header.chunk_size;
+        }
+    }
+    for (int i = 0; i < config.threads; i++) {
+        workers.emplace_back(&ChunkStreamer::workerLoop, this);
+    }
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    for (Chunk& chunk : done) {
+        freeChunk(chunk);
+    }
+    for (auto& [key, chunk] : ready) {
+        freeChunk(chunk);
+    }
+}
+
+void ChunkStreamer::workerLoop() {
+    profilerSetThreadName("chunks");
+    for (;;) {
+        chunk_key_t key;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || !jobs.empty(); });
+            if (stopping)
+                return;
+            key = jobs.front();
+            jobs.pop_front();
+        }
+        Chunk chunk = produce(key);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.push_back(std::move(chunk));
+        }
+        finished.notify_all();
+    }
+}
+
+Chunk ChunkStreamer::produce(const chunk_key_t& key) {
+    if (store.isOpen())
+        return loadChunk(store, key);
+    return generateChunk(config, seed, key);
+}
+
+void ChunkStreamer::add(Chunk chunk, long int tick,
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+    std::vector<Obstacle*>& added,
+    std::vector<BakedBrick>& baked) {
+    pending.erase(chunk.key);
+    for (Obstacle* obstacle : chunk.obstacles) {
+        box_map[positionToCell(obstacle->getPos())].push_back(obstacle);
+        added.push_back(obstacle);
+    }
+    baked.insert(baked.end(), chunk.bricks.begin(), chunk.bricks.end());
+    chunk.last_used = tick;
+    bytes += chunk.bytes;
+    countEvent(COUNTER_CHUNKS_LOADED);
+    loaded.emplace(chunk.key, std::move(chunk));
+}
+
+void ChunkStreamer::evict(const chunk_key_t& key,
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+    std::vector<Obstacle*>& removed) {
+    auto it = loaded.find(key);
+    for (Obstacle* obstacle : it->second.obstacles) {
+        auto cellIt = box_map.find(positionToCell(obstacle->getPos()));
+        if (cellIt != box_map.end()) {
+            std::vector<Obstacle*>& cell = cellIt->second;
+            cell.erase(std::remove(cell.begin(), cell.end(), obstacle), cell.end());
+            if (cell.empty())
+                box_map.erase(cellIt);
+        }
+        removed.push_back(obstacle);
+    }
+    bytes -= it->second.bytes;
+    countEvent(COUNTER_CHUNKS_EVICTED);
+    loaded.erase(it);
+}
+
+void ChunkStreamer::collectDone(bool wait) {
+    std::vector<Chunk> arrived;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (wait)
+            finished.wait(lock, [&] { return !done.empty(); });
+        arrived.swap(done);
+    }
+    for (Chunk& chunk : arrived) {
+        // Cancelled while a worker had it, or a second copy after a re-request
+        if (pending.count(chunk.key) == 0 || ready.count(chunk.key) != 0) {
+            freeChunk(chunk);
+            continue;
+        }
+        ready.emplace(chunk.key, std::move(chunk));
+    }
+}
+
+bool ChunkStreamer::update(const glm::vec3& pos, long int tick, bool block,
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+    DistanceField& field,
+    std::vector<const Obstacle*>& evicted) {
+    PROFILE_ZONE("ChunkStreamer::update");
+    chunk_key_t center = positionToChunk(pos, config.size);
+    // Nothing to request, add or evict until the player changes chunk
+    if (!block && has_center && center == last_center && pending.empty())
+        return false;
+    last_center = center;
+    has_center = true;
+    auto inRange = [&](const chunk_key_t& key) {
+        return std::abs(std::get<0>(key) - std::get<0>(center)) <= config.loadRadius
+            && std::abs(std::get<1>(key) - std::get<1>(center)) <= config.loadRadius
+            && std::abs(std::get<2>(key) - std::get<2>(center)) <= config.loadRadius;
+    };
+
+    // Missing chunks nearest first, so the player's own chunk is generated first
+    std::vector<chunk_key_t> missing;
+    for (int x = -config.loadRadius; x <= config.loadRadius; x++) {
+        for (int y = -config.loadRadius; y <= config.loadRadius; y++) {
+            for (int z = -config.loadRadius; z <= config.loadRadius; z++) {
+                chunk_key_t key = std::make_tuple(
+                    std::get<0>(center) + x, std::get<1>(center) + y, std::get<2>(center) + z);
+                auto it = loaded.find(key);
+                if (it != loaded.end()) {
+                    it->second.last_used = tick;
+                } else if (pending.count(key) == 0) {
+                    missing.push_back(key);
+                }
+            }
+        }
+    }
+    std::sort(missing.begin(), missing.end(), [&](const chunk_key_t& a, const chunk_key_t& b) {
+        auto distance = [&](const chunk_key_t& k) {
+            int dx = std::get<0>(k) - std::get<0>(center);
+            int dy = std::get<1>(k) - std::get<1>(center);
+            int dz = std::get<2>(k) - std::get<2>(center);
+            return dx * dx + dy * dy + dz * dz;
+        };
+        return distance(a) < distance(b);
+    });
+
+    // The player moved away before they were due, a worker may still finish them
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (inRange(it->first)) {
+            ++it;
+            continue;
+        }
+        auto readyIt = ready.find(it->first);
+        if (readyIt != ready.end()) {
+            freeChunk(readyIt->second);
+            ready.erase(readyIt);
+        }
+        it = pending.erase(it);
+    }
+
+    long int due = block ? tick : tick + config.latency;
+    if (workers.empty()) {
+        for (const chunk_key_t& key : missing) {
+            pending[key] = due;
+            ready.emplace(key, produce(key));
+        }
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+                [&](const chunk_key_t& key) { return pending.count(key) == 0; }), jobs.end());
+            for (const chunk_key_t& key : missing) {
+                jobs.push_back(key);
+                pending[key] = due;
+            }
+        }
+        if (!missing.empty())
+            wake.notify_all();
+        collectDone(false);
+    }
+
+    // Chunks go in on the tick they are due, never earlier or later, so the
+    // world does not depend on how fast the workers were. In key order, so
+    // box_map is filled the same way every run.
+    std::vector<chunk_key_t> dueKeys;
+    for (const auto& [key, dueTick] : pending) {
+        if (dueTick <= tick)
+            dueKeys.push_back(key);
+    }
+    std::sort(dueKeys.begin(), dueKeys.end());
+
+    std::vector<Obstacle*> added;
+    std::vector<BakedBrick> baked;
+    for (const chunk_key_t& key : dueKeys) {
+        auto it = ready.find(key);
+        while (it == ready.end()) {
+            // Late, the step waits for it rather than running without it
+            PROFILE_ZONE("ChunkStreamer::wait");
+            collectDone(true);
+            it = ready.find(key);
+        }
+        add(std::move(it->second), tick, box_map, added, baked);
+        ready.erase(it);
+    }
+
+    // Baked bricks are only any good for a field with the settings they were baked for
+    if (!store.bricksMatch(field))
+        baked.clear();
+    if (!added.empty() || !baked.empty())
+        field.addObstacles(added, baked);
+    bool changed = !dueKeys.empty();
+
+    // Least recently used first, never a chunk the player is in range of.
+    // Chunks used on the same tick go by key, not by the map's order, which
+    // depends on the history of the map and differs after a restore.
+    std::vector<Obstacle*> removed;
+    while (bytes > config.budgetBytes) {
+        auto oldest = loaded.end();
+        for (auto it = loaded.begin(); it != loaded.end(); ++it) {
+            if (inRange(it->first))
+                continue;
+            if (oldest == loaded.end() || it->second.last_used < oldest->second.last_used
+                    || (it->second.last_used == oldest->second.last_used && it->first < oldest->first))
+                oldest = it;
+        }
+        if (oldest == loaded.end())
+            break;
+        evict(oldest->first, box_map, removed);
+        changed = true;
+    }
+    if (!removed.empty()) {
+        field.removeObstacles(removed);
+        for (Obstacle* obstacle : removed) {
+            evicted.push_back(obstacle);
+            delete obstacle;
+        }
+    }
+
+    return changed;
+}
+
+ChunkStreamerState ChunkStreamer::getState() const {
+    ChunkStreamerState state;
+    state.has_center = has_center;
+    state.center = last_center;
+    for (const auto& [key, chunk] : loaded) {
+        state.loaded.emplace_back(key, chunk.last_used);
+    }
+    for (const auto& [key, due] : pending) {
+        state.pending.emplace_back(key, due);
+    }
+    std::sort(state.loaded.begin(), state.loaded.end());
+    std::sort(state.pending.begin(), state.pending.end());
+    return state;
+}
+
+void ChunkStreamer::setState(const ChunkStreamerState& state,
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
+    DistanceField& field,
+    std::vector<const Obstacle*>& evicted) {
+    PROFILE_ZONE("ChunkStreamer::setState");
+    // Requests in flight are dropped, a worker's late result is freed when it arrives
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.clear();
+    }
+    for (auto& [key, chunk] : ready) {
+        freeChunk(chunk);
+    }
+    ready.clear();
+    pending.clear();
+
+    std::unordered_map<chunk_key_t, long int> keep(state.loaded.begin(), state.loaded.end());
+    std::vector<chunk_key_t> stale;
+    for (const auto& [key, chunk] : loaded) {
+        if (keep.count(key) == 0)
+            stale.push_back(key);
+    }
+    std::sort(stale.begin(), stale.end());
+    std::vector<Obstacle*> removed;
+    for (const chunk_key_t& key : stale) {
+        evict(key, box_map, removed);
+    }
+    if (!removed.empty()) {
+        field.removeObstacles(removed);
+        for (Obstacle* obstacle : removed) {
+            evicted.push_back(obstacle);
+            delete obstacle;
+        }
+    }
+
+    std::vector<Obstacle*> added;
+    std::vector<BakedBrick> baked;
+    for (const auto& [key, last_used] : state.loaded) {
+        if (loaded.count(key) == 0)
+            add(produce(key), last_used, box_map, added, baked);
+        loaded[key].last_used = last_used;
+    }
+    if (!store.bricksMatch(field))
+        baked.clear();
+    if (!added.empty() || !baked.empty())
+        field.addObstacles(added, baked);
+
+    for (const auto& [key, due] : state.pending) {
+        pending[key] = due;
+    }
+    if (workers.empty()) {
+        for (const auto& [key, due] : state.pending) {
+            ready.emplace(key, produce(key));
+        }
+    } else if (!state.pending.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& [key, due] : state.pending) {
+                jobs.push_back(key);
+            }
+        }
+        wake.notify_all();
+    }
+    has_center = state.has_center;
+    last_center = state.center;
+}
+
+std::vector<glm::vec3> ChunkStreamer::collectStars() const {
+    std::vector<glm::vec3> stars;
+    for (const auto& [key, chunk] : loaded) {
+        stars.insert(stars.end(), chunk.stars.begin(), chunk.stars.end());
+    }
+    return stars;
+}
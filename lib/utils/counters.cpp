@@ -0,0 +1,54 @@
+#include "utils/counters.h"
+
+
+namespace counters_detail {
+Shard shards[COUNTER_SHARDS] = {};
+
+thread_local unsigned shard = COUNTER_SHARDS;
+
+static std::atomic<unsigned> next_shard(0);
+
+unsigned assignShard() {
+    shard = next_shard.fetch_add(1, std::memory_order_relaxed) % COUNTER_SHARDS;
+    return shard;
+}
+}
+
+const char* counterName(counter_t counter) {
+    switch (counter) {
+        case COUNTER_RAYCASTS:        return "raycasts";
+        case COUNTER_FIELD_SAMPLES:   return "field_samples";
+        case COUNTER_CONTAINS:        return "contains";
+        case COUNTER_NEIGHBOR_PAIRS:  return "neighbor_pairs";
+        case COUNTER_CELLS_TOUCHED:   return "cells_touched";
+        case COUNTER_FAR_FLOCKS:      return "far_flocks";
+        case COUNTER_FAR_FLOCK_BOIDS: return "far_flock_boids";
+        case COUNTER_BOIDS_SPAWNED:   return "boids_spawned";
+        case COUNTER_BOIDS_KILLED:    return "boids_killed";
+        case COUNTER_BULLET_STEPS:    return "bullet_steps";
+        case COUNTER_CHUNKS_LOADED:   return "chunks_loaded";
+        case COUNTER_CHUNKS_EVICTED:  return "chunks_evicted";
+        case COUNTER_GL_UPLOADS:      return "gl_uploads";
+        case COUNTER_GL_CREATED:      return "gl_created";
+        case COUNTER_GL_DELETED:      return "gl_deleted";
+        default:                      return "unknown";
+    }
+}
+
+CounterSample counterDelta(const CounterSample& a, const CounterSample& b) {
+    CounterSample delta;
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        delta.values[c] = b.values[c] - a.values[c];
+    }
+    return delta;
+}
+
+CounterSample countersSnapshot() {
+    CounterSample sample;
+    for (const counters_detail::Shard& shard : counters_detail::shards) {
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            sample.values[c] += shard.values[c].load(std::memory_order_relaxed);
+        }
+    }
+    return sample;
+}
@@ -3,13 +3,14 @@
 #include <tuple>
 #include <glm/glm.hpp>
 #include <unordered_map>
-#include <random>
+#include "utils/random.h"
 
 #include <functional>
 
-#include "utils/model.h"
 #include "shapes/box.h"
 #include "shapes/boid.h"
+#include "algorithm/morton.h"
+#include "utils/counters.h"
 
 std::tuple<int, int, int> positionToCell(const glm::vec3& pos) {
     int cellX = static_cast<int>(std::ceil(pos.x) / CELL_SIZE);
@@ -19,66 +20,48 @@ std::tuple<int, int, int> positionToCell(const glm::vec3& pos) {
     return std::make_tuple(cellX, cellY, cellZ);
 }
 
-void drawChunkBorders(const std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle>>& box_map) {
-    // Define the half size of a cell
-    float halfCellSize = CELL_SIZE / 2.0f;
-
-    for (const auto& [cell, boxes] : box_map) {
-        int cellX, cellY, cellZ;
-        std::tie(cellX, cellY, cellZ) = cell;
-
-        // Calculate the center of this cell
-        glm::vec3 center(cellX * CELL_SIZE, cellY * CELL_SIZE, cellZ * CELL_SIZE);
-
-        // Define the 8 corners of the wireframe box
-        glm::vec3 corners[8] = {
-            center + glm::vec3(-halfCellSize, -halfCellSize, -halfCellSize),
-            center + glm::vec3(halfCellSize, -halfCellSize, -halfCellSize),
-            center + glm::vec3(halfCellSize, halfCellSize, -halfCellSize),
-            center + glm::vec3(-halfCellSize, halfCellSize, -halfCellSize),
-            center + glm::vec3(-halfCellSize, -halfCellSize, halfCellSize),
-            center + glm::vec3(halfCellSize, -halfCellSize, halfCellSize),
-            center + glm::vec3(halfCellSize, halfCellSize, halfCellSize),
-            center + glm::vec3(-halfCellSize, halfCellSize, halfCellSize),
-        };
-
-        // Set color for the cell borders (e.g., light gray)
-        glColor3f(0.7f, 0.7f, 0.7f);
-
-        // Draw edges of the cube
-        glBegin(GL_LINES);
-        for (int i = 0; i < 4; ++i) {
-            // Bottom square
-            glVertex3fv(&corners[i].x);
-            glVertex3fv(&corners[(i + 1) % 4].x);
-
-            // Top square
-            glVertex3fv(&corners[i + 4].x);
-            glVertex3fv(&corners[(i + 1) % 4 + 4].x);
-
-            // Vertical lines connecting top and bottom squares
-            glVertex3fv(&corners[i].x);
-            glVertex3fv(&corners[i + 4].x);
-        }
-        glEnd();
-    }
+// Inverse of positionToCell's ceil-then-truncate rounding along one axis
+static float cellAxisCenter(int cell) {
+    if (cell > 0)
+        return cell * CELL_SIZE - 1.0f + CELL_SIZE / 2.0f;
+    if (cell < 0)
+        return (cell - 0.5f) * CELL_SIZE;
+    return -0.5f;
+}
+
+glm::vec3 cellCenter(const std::tuple<int, int, int>& cell) {
+    return glm::vec3(
+        cellAxisCenter(std::get<0>(cell)),
+        cellAxisCenter(std::get<1>(cell)),
+        cellAxisCenter(std::get<2>(cell)));
 }
 
+// Cell 0 takes ceil values -1, 0 and 1, so it is half again as wide as the others
+static float cellAxisHalfExtent(int cell) {
+    return cell == 0 ? CELL_SIZE * 0.75f : CELL_SIZE / 2.0f;
+}
+
+glm::vec3 cellHalfExtent(const std::tuple<int, int, int>& cell) {
+    return glm::vec3(
+        cellAxisHalfExtent(std::get<0>(cell)),
+        cellAxisHalfExtent(std::get<1>(cell)),
+        cellAxisHalfExtent(std::get<2>(cell)));
+}
 
 glm::vec3 getRandomPointOutsideObstacles(
     std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>& box_map,
     float maxPosition,
-    float minDistance = 0.5f) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> posDist(-maxPosition, maxPosition);
-
+    float minDistance,
+    Rng& rng) {
     glm::vec3 randomPoint;
     bool isValid;
 
     do {
         // Generate a random point
-        randomPoint = glm::vec3(posDist(gen), posDist(gen), posDist(gen));
+        randomPoint = glm::vec3(
+            rng.uniform(-maxPosition, maxPosition),
+            rng.uniform(-maxPosition, maxPosition),
+            rng.uniform(-maxPosition, maxPosition));
         isValid = true;
 
         std::vector<Obstacle*>& boxes = box_map[positionToCell(randomPoint)];
@@ -108,33 +91,25 @@ glm::vec3 getRandomPointOutsideObstacles(
 
 
 std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>> generateRandomBoxes(
-    int numObstaclees, float maxSize, float maxPosition) {
+    int numObstaclees, float maxSize, float maxPosition, uint64_t seed) {
     std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>> result;
 
-    // Seed the random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
-    // Define the random distributions
-    std::uniform_real_distribution<float> sizeDist(0.5f, maxSize);        // Obstacle size range
-    std::uniform_real_distribution<float> posDist(-maxPosition, maxPosition); // Position range
-    std::uniform_real_distribution<float> colorDist(0.0f, 1.0f);
-
-    // Create random boxes
+    // Create random boxes, each keyed by its index
     for (int i = 0; i < numObstaclees; ++i) {
-        float width = sizeDist(gen);
-        float height = sizeDist(gen);
-        float depth = sizeDist(gen);
+        Rng rng(seed, RNG_BOXES, i);
+        float width = rng.uniform(0.5f, maxSize);
+        float height = rng.uniform(0.5f, maxSize);
+        float depth = rng.uniform(0.5f, maxSize);
 
-        float x = posDist(gen);
-        float y = posDist(gen);
-        float z = posDist(gen);
+        float x = rng.uniform(-maxPosition, maxPosition);
+        float y = rng.uniform(-maxPosition, maxPosition);
+        float z = rng.uniform(-maxPosition, maxPosition);
 
         std::tuple<int,int,int> cellKey = positionToCell(glm::vec3(x,y,z));
 
-        float r = colorDist(gen);
-        float g = colorDist(gen);
-        float b = colorDist(gen);
+        float r = rng.uniform();
+        float g = rng.uniform();
+        float b = rng.uniform();
 
         result[cellKey].push_back(new Box(width, height, depth, x, y, z, r, g, b));
     }
@@ -147,42 +122,66 @@ void generateRandomBoids(
     int count,
     int maxDistance,
     std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle*>>& box_map,
-    long int frame, glm::vec3 playerPos
+    long int frame, glm::vec3 playerPos, uint64_t seed, unsigned long& next_id
     ){
 
     if(count <= 0)
       return;
+    countEvent(COUNTER_BOIDS_SPAWNED, count);
 
     for (int i = 0; i < count; ++i) {
-      glm::vec3 randomPos = playerPos + getRandomPointOutsideObstacles(box_map, maxDistance);
+      Rng rng(seed, RNG_BOID_SPAWN, i, frame);
+      glm::vec3 randomPos = playerPos + getRandomPointOutsideObstacles(box_map, maxDistance, 0.5f, rng);
       result[positionToCell(randomPos)].push_back(
-          Boid(frame, randomPos)
+          Boid(frame, randomPos, next_id++, seed)
           );
     }
 }
 
 std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> recalculateCells(
-    std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> old_map, int& num_boids
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> boid_map, int& num_boids,
+    MortonOrder& order, long int frame
     ){
 
-    std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> new_map;
+    // Most boids stay in their cell and are not touched. The ones that left
+    // are taken out cell by cell in Morton order, so the order they join
+    // their new cells in only depends on the keys, not on the map's history.
+    order.sort(boid_map, frame);
+    std::vector<Boid> movers;
+    for(const std::tuple<int,int,int>& cell : order.getCells()){
+      std::vector<Boid>& boids = boid_map.find(cell)->second;
+      size_t kept = 0;
+      for(size_t i = 0; i < boids.size(); i++){
+        if(positionToCell(boids[i].getPos()) != cell){
+          movers.push_back(std::move(boids[i]));
+        } else {
+          if(kept != i)
+            boids[kept] = std::move(boids[i]);
+          kept++;
+        }
+      }
+      boids.resize(kept, Boid(0, glm::vec3(0.0f), 0));
+    }
+    for(Boid& boid : movers){
+      boid_map[positionToCell(boid.getPos())].push_back(std::move(boid));
+    }
+
     num_boids = 0;
-    for(auto& [cell, boids] : old_map){
-      for(Boid& boid : boids){
-        new_map[positionToCell(boid.getPos())].push_back(boid);
-        num_boids++;
+    for(auto it = boid_map.begin(); it != boid_map.end();){
+      if(it->second.empty()){
+        it = boid_map.erase(it);
+      } else {
+        num_boids += it->second.size();
+        ++it;
       }
     }
-    return new_map;
+    order.sort(boid_map, frame);
+    return boid_map;
 }
 
-bool shouldSpawnBoid(long frame) {
+bool shouldSpawnBoid(long frame, uint64_t seed) {
     // Base probability of spawning, which increases with the frame count
     float spawnProbability = std::min(0.01f + (frame / 100000.0f), 1.0f); // Caps at 100% chance
 
-    // Generate a random float between 0 and 1
-    float randomValue = static_cast<float>(rand()) / RAND_MAX;
-
-    // Spawn a boid if the random value is below the calculated probability
-    return randomValue < spawnProbability;
+    return Rng(seed, RNG_SPAWN_CHANCE, 0, frame).chance(spawnProbability);
 }
@@ -0,0 +1,125 @@
+#include "utils/loader.h"
+#include <algorithm>
+
+#include "utils/profiler.h"
+
+
+AsyncLoader::AsyncLoader(int threads) {
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&AsyncLoader::workerLoop, this);
+    }
+}
+
+AsyncLoader::~AsyncLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void AsyncLoader::add(const char* name, float weight, std::function<void()> work, std::function<void()> finish) {
+    Job job{name, weight, std::move(work), std::move(finish)};
+    total += weight;
+    // Without workers the work runs on the next poll like a main job
+    if (workers.empty()) {
+        main_jobs.push_back(std::move(job));
+        std::lock_guard<std::mutex> lock(mutex);
+        outstanding++;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+        outstanding++;
+    }
+    wake.notify_one();
+}
+
+void AsyncLoader::addMain(const char* name, float weight, std::function<void()> work) {
+    total += weight;
+    main_jobs.push_back(Job{name, weight, std::move(work), {}});
+    std::lock_guard<std::mutex> lock(mutex);
+    outstanding++;
+}
+
+bool AsyncLoader::poll(double budgetMs) {
+    PROFILE_ZONE("AsyncLoader::poll");
+    uint64_t start = profilerNow();
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(done);
+    }
+    auto complete = [&](const Job& job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished += job.weight;
+        outstanding--;
+    };
+    for (Job& job : ready) {
+        if (job.finish) {
+            ProfileZone zone(job.name);
+            job.finish();
+        }
+        complete(job);
+    }
+    do {
+        if (main_jobs.empty())
+            break;
+        Job job = std::move(main_jobs.front());
+        main_jobs.pop_front();
+        {
+            ProfileZone zone(job.name);
+            job.work();
+            if (job.finish)
+                job.finish();
+        }
+        complete(job);
+    } while ((profilerNow() - start) * 1e-6 < budgetMs);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return outstanding == 0;
+}
+
+float AsyncLoader::progress() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total > 0.0f ? std::min(finished / total, 1.0f) : 1.0f;
+}
+
+std::string AsyncLoader::current() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running.empty())
+        return running.front();
+    if (!main_jobs.empty())
+        return main_jobs.front().name;
+    if (!jobs.empty())
+        return jobs.front().name;
+    return "";
+}
+
+void AsyncLoader::workerLoop() {
+    profilerSetThreadName("loader");
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&] { return stopping || !jobs.empty(); });
+        if (stopping)
+            return;
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        running.push_back(job.name);
+        lock.unlock();
+
+        {
+            ProfileZone zone(job.name);
+            job.work();
+        }
+
+        lock.lock();
+        running.erase(std::find(running.begin(), running.end(), job.name));
+        done.push_back(std::move(job));
+    }
+}
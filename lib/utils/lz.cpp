@@ -0,0 +1,115 @@
+#include "utils/lz.h"
+#include <cstring>
+
+#define LZ_HASH_BITS 14
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+
+
+static uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Lengths past a nibble's 15 continue in bytes of 255 ended by a smaller one
+static void putLength(std::vector<uint8_t>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+static void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalLength,
+    size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength >= LZ_MIN_MATCH ? matchLength - LZ_MIN_MATCH : 0;
+    uint8_t token = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4
+        | (matchCode < 15 ? matchCode : 15));
+    out.push_back(token);
+    if (literalLength >= 15)
+        putLength(out, literalLength - 15);
+    out.insert(out.end(), literals, literals + literalLength);
+    if (matchLength == 0)
+        return;
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchCode >= 15)
+        putLength(out, matchCode - 15);
+}
+
+void lzCompress(const uint8_t* in, size_t size, std::vector<uint8_t>& out) {
+    // Last position + 1 each 4 byte sequence was seen at, 0 for never
+    std::vector<uint32_t> table(size_t(1) << LZ_HASH_BITS, 0);
+
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + LZ_MIN_MATCH <= size) {
+        uint32_t sequence = read32(in + i);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i + 1);
+
+        if (candidate != 0 && i - (candidate - 1) <= LZ_MAX_OFFSET && read32(in + candidate - 1) == sequence) {
+            size_t match = candidate - 1;
+            size_t length = LZ_MIN_MATCH;
+            while (i + length < size && in[match + length] == in[i + length]) {
+                length++;
+            }
+            putSequence(out, in + anchor, i - anchor, i - match, length);
+            i += length;
+            anchor = i;
+        } else {
+            i++;
+        }
+    }
+    putSequence(out, in + anchor, size - anchor, 0, 0);
+}
+
+bool lzDecompress(const uint8_t* in, size_t size, uint8_t* out, size_t outSize) {
+    const uint8_t* ip = in;
+    const uint8_t* end = in + size;
+    size_t op = 0;
+
+    auto getLength = [&](size_t& length) {
+        uint8_t b;
+        do {
+            if (ip >= end)
+                return false;
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !getLength(literalLength))
+            return false;
+        if (literalLength > size_t(end - ip) || literalLength > outSize - op)
+            return false;
+        std::memcpy(out + op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            return false;
+        size_t offset = ip[0] | size_t(ip[1]) << 8;
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !getLength(matchLength))
+            return false;
+        matchLength += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || matchLength > outSize - op)
+            return false;
+        // Byte by byte, a match may overlap the bytes it is producing
+        for (size_t k = 0; k < matchLength; k++) {
+            out[op + k] = out[op + k - offset];
+        }
+        op += matchLength;
+    }
+    return op == outSize;
+}
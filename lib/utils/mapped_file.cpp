@@ -0,0 +1,58 @@
+#include "utils/mapped_file.h"
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP 1
+#endif
+
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, bool random) {
+    close();
+    error.clear();
+#ifdef MAPPED_FILE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "could not open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        error = path + " is empty";
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive on its own
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "could not map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    if (random)
+        madvise(mapped, info.st_size, MADV_RANDOM);
+    base = mapped;
+    length = info.st_size;
+    return true;
+#else
+    error = "memory mapped files are not available on this platform";
+    return false;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef MAPPED_FILE_MMAP
+    if (base != nullptr)
+        munmap(base, length);
+#endif
+    base = nullptr;
+    length = 0;
+}
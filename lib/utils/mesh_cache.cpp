@@ -0,0 +1,91 @@
+#include "utils/mesh_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "utils/mapped_file.h"
+#include "utils/profiler.h"
+
+
+static_assert(sizeof(MeshFileHeader) == 48, "header layout is part of the file format");
+static_assert(sizeof(MeshLod) == 12, "level layout is part of the file format");
+
+static std::string cachePath(const std::string& dir, uint64_t sourceHash, float scale, int sampleRate) {
+    uint32_t scaleBits = 0;
+    std::memcpy(&scaleBits, &scale, sizeof(scaleBits));
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%08x-%d.bmsh",
+        static_cast<unsigned long long>(sourceHash), scaleBits, sampleRate);
+    return dir + "/" + name;
+}
+
+bool loadCachedMesh(const std::string& dir, uint64_t sourceHash, float scale, int sampleRate,
+        std::vector<float>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods) {
+    PROFILE_ZONE("loadCachedMesh");
+    MappedFile file;
+    if (!file.open(cachePath(dir, sourceHash, scale, sampleRate)) || file.size() < sizeof(MeshFileHeader))
+        return false;
+    MeshFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION
+            || header.source_hash != sourceHash || header.scale != scale || header.sample_rate != uint32_t(sampleRate)
+            || header.vertex_floats % 6 != 0
+            || header.vertex_floats > file.size() / sizeof(float) || header.index_count > file.size() / sizeof(uint32_t)
+            || header.lod_count == 0 || header.lod_count > file.size() / sizeof(MeshLod)
+            || sizeof(header) + header.vertex_floats * sizeof(float) + header.lod_count * sizeof(MeshLod)
+                + header.index_count * sizeof(uint32_t) != file.size())
+        return false;
+    std::vector<MeshLod> levels(header.lod_count);
+    std::memcpy(levels.data(), file.data() + sizeof(header) + header.vertex_floats * sizeof(float),
+        header.lod_count * sizeof(MeshLod));
+    for (const MeshLod& lod : levels) {
+        if (lod.index_count % 3 != 0 || lod.first_index > header.index_count
+                || lod.index_count > header.index_count - lod.first_index)
+            return false;
+    }
+
+    const char* data = file.data() + sizeof(header);
+    size_t first = vertices.size();
+    vertices.resize(first + header.vertex_floats);
+    std::memcpy(vertices.data() + first, data, header.vertex_floats * sizeof(float));
+    data += header.vertex_floats * sizeof(float) + header.lod_count * sizeof(MeshLod);
+    lods = std::move(levels);
+    indices.resize(header.index_count);
+    std::memcpy(indices.data(), data, header.index_count * sizeof(uint32_t));
+    return true;
+}
+
+bool storeCachedMesh(const std::string& dir, uint64_t sourceHash, float scale, int sampleRate,
+        const float* vertices, size_t vertexFloats, const std::vector<uint32_t>& indices,
+        const std::vector<MeshLod>& lods) {
+    MeshFileHeader header = {};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.source_hash = sourceHash;
+    header.scale = scale;
+    header.sample_rate = sampleRate;
+    header.vertex_floats = vertexFloats;
+    header.index_count = indices.size();
+    header.lod_count = lods.size();
+
+    // Written aside and renamed, another process never maps half a file
+    std::error_code failed;
+    std::filesystem::create_directories(dir, failed);
+    std::string path = cachePath(dir, sourceHash, scale, sampleRate);
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(vertices), vertexFloats * sizeof(float));
+        out.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(MeshLod));
+        out.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temp, failed);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, path, failed);
+    return !failed;
+}
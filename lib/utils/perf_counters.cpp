@@ -0,0 +1,130 @@
+#include "utils/perf_counters.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+const char* perfCounterName(perf_counter_t counter) {
+    switch (counter) {
+        case PERF_CYCLES:        return "cycles";
+        case PERF_INSTRUCTIONS:  return "instructions";
+        case PERF_CACHE_MISSES:  return "cache_misses";
+        case PERF_BRANCH_MISSES: return "branch_misses";
+        default:                 return "unknown";
+    }
+}
+
+PerfSample perfDelta(const PerfSample& a, const PerfSample& b) {
+    PerfSample delta;
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (b.values[c] >= a.values[c])
+            delta.values[c] = b.values[c] - a.values[c];
+    }
+    return delta;
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+#ifdef __linux__
+
+static int openCounter(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = group_fd < 0 ? 1 : 0;   // the leader starts the whole group
+    attr.exclude_kernel = 1;                // allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+bool PerfCounters::open() {
+    close();
+    const uint64_t configs[PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        int fd = openCounter(configs[c], leader);
+        if (fd < 0) {
+            if (error.empty())
+                error = std::string(perfCounterName(static_cast<perf_counter_t>(c))) + ": " + std::strerror(errno);
+            continue;
+        }
+        fds[c] = fd;
+        slots[c] = opened++;
+        if (leader < 0)
+            leader = fd;
+    }
+
+    if (leader < 0)
+        return false;
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::close() {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (fds[c] >= 0)
+            ::close(fds[c]);
+        fds[c] = -1;
+        slots[c] = -1;
+    }
+    opened = 0;
+    leader = -1;
+    error.clear();
+}
+
+PerfSample PerfCounters::read() const {
+    PerfSample sample;
+    if (leader < 0)
+        return sample;
+
+    // The number of counters, the time the group was enabled and the time it
+    // was actually on the PMU, then each value in open order
+    uint64_t buffer[3 + PERF_COUNTER_COUNT];
+    ssize_t size = ::read(leader, buffer, sizeof(buffer));
+    if (size < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[2] == 0)
+        return sample;
+    uint64_t enabled = buffer[1];
+    uint64_t running = buffer[2];
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (slots[c] < 0 || static_cast<uint64_t>(slots[c]) >= buffer[0])
+            continue;
+        uint64_t value = buffer[3 + slots[c]];
+        if (running < enabled)
+            value = static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
+        sample.values[c] = value;
+    }
+    return sample;
+}
+
+#else
+
+bool PerfCounters::open() {
+    error = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+void PerfCounters::close() {
+}
+
+PerfSample PerfCounters::read() const {
+    return PerfSample();
+}
+
+#endif
@@ -0,0 +1,228 @@
+#include "utils/profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+#ifdef PROFILER_TSC
+#include <cpuid.h>
+#endif
+
+
+namespace profiler_detail {
+std::atomic<bool> enabled(true);
+thread_local uint32_t depth = 0;
+
+uint64_t steadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Spins for PROFILER_CALIBRATION_NS. The base is a steady clock reading, so
+// timestamps taken before this ran are on the same time line.
+static TscClock calibrate() {
+    TscClock clock = {false, 0, 0, 0};
+#ifdef PROFILER_TSC
+    // Invariant TSC: constant rate through frequency and sleep states, synced across cores
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 8)))
+        return clock;
+    uint64_t start_ns = steadyNow(), start_tsc = __rdtsc();
+    uint64_t end_ns, end_tsc;
+    do {
+        end_ns = steadyNow();
+        end_tsc = __rdtsc();
+    } while (end_ns - start_ns < PROFILER_CALIBRATION_NS);
+    if (end_tsc <= start_tsc)
+        return clock;
+    clock.mult = ((end_ns - start_ns) << 32) / (end_tsc - start_tsc);
+    clock.base_tsc = end_tsc;
+    clock.base_ns = end_ns;
+    clock.usable = clock.mult != 0;
+#endif
+    return clock;
+}
+
+const TscClock tsc = calibrate();
+}
+
+namespace {
+
+// One event. seq is 2 * index + 1 while event index is being written and
+// 2 * index + 2 once it is complete, so a snapshot can tell a slot that holds
+// the event it wants from one the owner is overwriting. The fields are atomics
+// for the same reason. Release stores and acquire loads keep a field from a
+// newer event from passing the seq check, on x86 they are plain moves.
+struct Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+    std::atomic<uint32_t> depth{0};
+    std::atomic<uint32_t> kind{0};
+};
+
+// Written only by its own thread. head counts every zone ever recorded, the
+// slot is head % PROFILER_RING_SIZE, so old zones are overwritten in place.
+struct ThreadRing {
+    Slot slots[PROFILER_RING_SIZE];
+    std::atomic<uint64_t> head{0};
+    std::string name;
+    uint32_t id = 0;
+};
+
+// Rings outlive their threads so a dump still sees zones from finished workers
+std::mutex rings_mutex;
+std::vector<std::unique_ptr<ThreadRing>>& rings() {
+    static std::vector<std::unique_ptr<ThreadRing>> all;
+    return all;
+}
+
+ThreadRing* registerThread() {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    rings().push_back(std::make_unique<ThreadRing>());
+    ThreadRing* ring = rings().back().get();
+    ring->id = rings().size();
+    ring->name = ring->id == 1 ? "main" : "thread " + std::to_string(ring->id);
+    return ring;
+}
+
+thread_local ThreadRing* local_ring = nullptr;
+
+ThreadRing* localRing() {
+    if (local_ring == nullptr)
+        local_ring = registerThread();
+    return local_ring;
+}
+
+void push(const char* name, uint64_t start_ns, uint64_t end_ns, uint32_t depth, profile_event_t kind) {
+    ThreadRing* ring = localRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    Slot& slot = ring->slots[head & (PROFILER_RING_SIZE - 1)];
+    slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_release);
+    slot.start_ns.store(start_ns, std::memory_order_release);
+    slot.end_ns.store(end_ns, std::memory_order_release);
+    slot.depth.store(depth, std::memory_order_release);
+    slot.kind.store(kind, std::memory_order_release);
+    slot.seq.store(2 * head + 2, std::memory_order_release);
+    // Publishes the slot to snapshots taken on other threads
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Copies event index out of its slot, false if the owner has reused the slot
+// or is writing it right now
+bool read(const ThreadRing& ring, uint64_t index, ProfileEvent& event) {
+    const Slot& slot = ring.slots[index & (PROFILER_RING_SIZE - 1)];
+    uint64_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq != 2 * index + 2)
+        return false;
+    event.name = slot.name.load(std::memory_order_acquire);
+    event.start_ns = slot.start_ns.load(std::memory_order_acquire);
+    event.end_ns = slot.end_ns.load(std::memory_order_acquire);
+    event.depth = slot.depth.load(std::memory_order_acquire);
+    event.kind = slot.kind.load(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == seq;
+}
+
+void writeJsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\')
+            out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+}
+
+void profilerSetEnabled(bool enabled) {
+    profiler_detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool profilerEnabled() {
+    return profiler_detail::enabled.load(std::memory_order_relaxed);
+}
+
+void profilerSetThreadName(const char* name) {
+    ThreadRing* ring = localRing();
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    ring->name = name;
+}
+
+void profilerRecord(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    push(name, start_ns, end_ns, profiler_detail::depth, PROFILE_EVENT_ZONE);
+}
+
+void profilerCounter(const char* name, uint64_t ts_ns, uint64_t value) {
+    push(name, ts_ns, value, 0, PROFILE_EVENT_COUNTER);
+}
+
+std::vector<ProfileThread> profilerSnapshot() {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    std::vector<ProfileThread> result;
+    for (const std::unique_ptr<ThreadRing>& ring : rings()) {
+        ProfileThread thread;
+        thread.name = ring->name;
+        thread.id = ring->id;
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+        thread.events.reserve(head - first);
+        // The owner keeps writing while we copy, the oldest slots it reuses are skipped
+        ProfileEvent event;
+        for (uint64_t i = first; i < head; i++) {
+            if (read(*ring, i, event))
+                thread.events.push_back(event);
+        }
+        result.push_back(std::move(thread));
+    }
+    return result;
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::vector<ProfileThread> threads = profilerSnapshot();
+
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    // Timestamps relative to the oldest zone keep the numbers short
+    uint64_t origin = UINT64_MAX;
+    for (const ProfileThread& thread : threads) {
+        for (const ProfileEvent& event : thread.events) {
+            origin = std::min(origin, event.start_ns);
+        }
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (const ProfileThread& thread : threads) {
+        out << (first ? "" : ",\n") << "{\"ph\": \"M\", \"pid\": 1, \"tid\": " << thread.id
+            << ", \"name\": \"thread_name\", \"args\": {\"name\": ";
+        writeJsonString(out, thread.name);
+        out << "}}";
+        first = false;
+
+        for (const ProfileEvent& event : thread.events) {
+            if (event.kind == PROFILE_EVENT_COUNTER) {
+                out << ",\n{\"ph\": \"C\", \"pid\": 1, \"name\": ";
+                writeJsonString(out, event.name);
+                out << ", \"ts\": " << (event.start_ns - origin) / 1000.0
+                    << ", \"args\": {\"value\": " << event.end_ns << "}}";
+                continue;
+            }
+            out << ",\n{\"ph\": \"X\", \"pid\": 1, \"tid\": " << thread.id << ", \"name\": ";
+            writeJsonString(out, event.name);
+            out << ", \"ts\": " << (event.start_ns - origin) / 1000.0
+                << ", \"dur\": " << (event.end_ns - event.start_ns) / 1000.0
+                << ", \"args\": {\"depth\": " << event.depth << "}}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,248 @@
+#include "utils/replay.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "utils/chunk_store.h"
+
+#define REPLAY_KEYS 1u
+#define REPLAY_YAW 2u
+#define REPLAY_PITCH 4u
+#define REPLAY_RADIUS 8u
+#define REPLAY_DELTA 16u
+
+
+static_assert(sizeof(ReplayHeader) == 48, "header layout is part of the file format");
+
+uint64_t chunkStoreHash(const std::string& path) {
+    if (path.empty())
+        return 0;
+    ChunkStore store;
+    if (!store.open(path))
+        return 0;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&store.getHeader());
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(ChunkStoreHeader); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint16_t packKeys(const PlayerInput& input) {
+    return uint16_t(input.forward) | uint16_t(input.back) << 1 | uint16_t(input.left) << 2
+        | uint16_t(input.right) << 3 | uint16_t(input.up) << 4 | uint16_t(input.down) << 5
+        | uint16_t(input.boost) << 6 | uint16_t(input.stop) << 7 | uint16_t(input.shoot) << 8;
+}
+
+static void unpackKeys(uint16_t keys, PlayerInput& input) {
+    input.forward = keys & 1;
+    input.back = keys >> 1 & 1;
+    input.left = keys >> 2 & 1;
+    input.right = keys >> 3 & 1;
+    input.up = keys >> 4 & 1;
+    input.down = keys >> 5 & 1;
+    input.boost = keys >> 6 & 1;
+    input.stop = keys >> 7 & 1;
+    input.shoot = keys >> 8 & 1;
+}
+
+// Bitwise, so -0.0 and NaN round trip and a replay never drifts from a compare
+static bool sameFloat(float a, float b) {
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static void putBytes(std::vector<uint8_t>& data, const void* value, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(value);
+    data.insert(data.end(), p, p + size);
+}
+
+static void putVarint(std::vector<uint8_t>& data, uint64_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<uint8_t>(value));
+}
+
+ReplayRecorder::~ReplayRecorder() {
+    if (isOpen())
+        close();
+}
+
+void ReplayRecorder::open(const std::string& path_, const WorldConfig& config) {
+    path = path_;
+    header = {};
+    header.magic = REPLAY_MAGIC;
+    header.version = REPLAY_VERSION;
+    header.flags = config.streaming ? REPLAY_STREAMING : 0;
+    header.seed = config.seed;
+    header.store_hash = chunkStoreHash(config.chunks.storePath);
+    data.clear();
+    // The first record is diffed against the defaults
+    last = PlayerInput();
+    run = 0;
+    error.clear();
+}
+
+void ReplayRecorder::flushRun() {
+    if (run == 0)
+        return;
+    data.push_back(0);
+    putVarint(data, run - 1);
+    run = 0;
+}
+
+void ReplayRecorder::record(const PlayerInput& input) {
+    if (!isOpen())
+        return;
+    header.tick_count++;
+    uint8_t mask = 0;
+    uint16_t keys = packKeys(input);
+    if (keys != packKeys(last)) mask |= REPLAY_KEYS;
+    if (!sameFloat(input.yaw, last.yaw)) mask |= REPLAY_YAW;
+    if (!sameFloat(input.pitch, last.pitch)) mask |= REPLAY_PITCH;
+    if (!sameFloat(input.radius, last.radius)) mask |= REPLAY_RADIUS;
+    if (!sameFloat(input.deltaTime, last.deltaTime)) mask |= REPLAY_DELTA;
+    if (mask == 0) {
+        run++;
+        return;
+    }
+    flushRun();
+    data.push_back(mask);
+    if (mask & REPLAY_KEYS) putBytes(data, &keys, sizeof(keys));
+    if (mask & REPLAY_YAW) putBytes(data, &input.yaw, sizeof(float));
+    if (mask & REPLAY_PITCH) putBytes(data, &input.pitch, sizeof(float));
+    if (mask & REPLAY_RADIUS) putBytes(data, &input.radius, sizeof(float));
+    if (mask & REPLAY_DELTA) putBytes(data, &input.deltaTime, sizeof(float));
+    last = input;
+}
+
+bool ReplayRecorder::close() {
+    if (!isOpen())
+        return true;
+    flushRun();
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    bool ok = bool(out);
+    if (!ok)
+        error = "could not write " + path;
+    path.clear();
+    return ok;
+}
+
+bool ReplayRecorder::close(uint64_t checksum) {
+    if (!isOpen())
+        return true;
+    header.flags |= REPLAY_CHECKSUM;
+    header.checksum = checksum;
+    return close();
+}
+
+bool ReplayReader::open(const std::string& path) {
+    inputs.clear();
+    error.clear();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "could not open " + path;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(header)) {
+        error = path + " is too small to be a replay";
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != REPLAY_MAGIC) {
+        error = path + " is not a replay";
+        return false;
+    }
+    if (header.version != REPLAY_VERSION) {
+        error = path + " is replay version " + std::to_string(header.version)
+            + ", expected " + std::to_string(REPLAY_VERSION);
+        return false;
+    }
+
+    const uint8_t* p = data.data() + sizeof(header);
+    const uint8_t* end = data.data() + data.size();
+    auto take = [&](void* value, size_t size) {
+        if (size > size_t(end - p))
+            return false;
+        std::memcpy(value, p, size);
+        p += size;
+        return true;
+    };
+
+    // Capped, a corrupt count should fail below rather than here
+    inputs.reserve(std::min<uint64_t>(header.tick_count, 1u << 20));
+    PlayerInput current;
+    bool ok = true;
+    while (ok && p < end && inputs.size() < header.tick_count) {
+        uint8_t mask = *p++;
+        if (mask == 0) {
+            uint64_t repeats = 0;
+            int shift = 0;
+            uint8_t byte = 0x80;
+            while (ok && (byte & 0x80)) {
+                ok = p < end && shift < 64;
+                if (ok) {
+                    byte = *p++;
+                    repeats |= uint64_t(byte & 0x7f) << shift;
+                    shift += 7;
+                }
+            }
+            ok = ok && repeats < header.tick_count - inputs.size();
+            if (ok)
+                inputs.insert(inputs.end(), repeats + 1, current);
+            continue;
+        }
+        if (mask & REPLAY_KEYS) {
+            uint16_t keys = 0;
+            ok = ok && take(&keys, sizeof(keys));
+            unpackKeys(keys, current);
+        }
+        if (mask & REPLAY_YAW) ok = ok && take(&current.yaw, sizeof(float));
+        if (mask & REPLAY_PITCH) ok = ok && take(&current.pitch, sizeof(float));
+        if (mask & REPLAY_RADIUS) ok = ok && take(&current.radius, sizeof(float));
+        if (mask & REPLAY_DELTA) ok = ok && take(&current.deltaTime, sizeof(float));
+        if (ok)
+            inputs.push_back(current);
+    }
+    if (!ok || p != end || inputs.size() != header.tick_count) {
+        error = path + " is truncated or corrupt";
+        inputs.clear();
+        return false;
+    }
+    return true;
+}
+
+void ReplayReader::apply(WorldConfig& config) const {
+    config.seed = header.seed;
+    config.streaming = getStreaming();
+}
+
+bool ReplayReader::checkStore(const WorldConfig& config) {
+    if (chunkStoreHash(config.chunks.storePath) == header.store_hash)
+        return true;
+    if (header.store_hash == 0)
+        error = "the replay was recorded without a baked world";
+    else if (config.chunks.storePath.empty())
+        error = "the replay was recorded on a baked world, none was given";
+    else
+        error = config.chunks.storePath + " is not the baked world the replay was recorded on";
+    return false;
+}
+
+bool ReplayReader::checkEnd(const World& world) {
+    if (!(header.flags & REPLAY_CHECKSUM) || world.checksum() == header.checksum)
+        return true;
+    char expected[17];
+    char actual[17];
+    std::snprintf(expected, sizeof(expected), "%016llx", static_cast<unsigned long long>(header.checksum));
+    std::snprintf(actual, sizeof(actual), "%016llx", static_cast<unsigned long long>(world.checksum()));
+    error = std::string("the replay ended on checksum ") + actual + ", the session ended on " + expected;
+    return false;
+}
@@ -0,0 +1,162 @@
+#include "utils/scenario.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+
+static std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r");
+    if (start == std::string::npos)
+        return "";
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(start, end - start + 1);
+}
+
+// "x,y,z"
+static bool parseVec3(const std::string& text, glm::vec3& out) {
+    char c1, c2;
+    std::istringstream in(text);
+    return static_cast<bool>(in >> out.x >> c1 >> out.y >> c2 >> out.z) && c1 == ',' && c2 == ',';
+}
+
+// "tick:rate tick:rate ..."
+static bool parseSpawnCurve(const std::string& text, std::vector<SpawnPoint>& curve) {
+    std::istringstream in(text);
+    std::string item;
+    while (in >> item) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos)
+            return false;
+        curve.push_back({std::stol(item.substr(0, colon)), std::stof(item.substr(colon + 1))});
+    }
+    std::sort(curve.begin(), curve.end(),
+        [](const SpawnPoint& a, const SpawnPoint& b) { return a.tick < b.tick; });
+    return !curve.empty();
+}
+
+// "tick:x,y,z tick:x,y,z ..."
+static bool parsePath(const std::string& text, std::vector<PathPoint>& path) {
+    std::istringstream in(text);
+    std::string item;
+    while (in >> item) {
+        size_t colon = item.find(':');
+        PathPoint point;
+        if (colon == std::string::npos || !parseVec3(item.substr(colon + 1), point.position))
+            return false;
+        point.tick = std::stol(item.substr(0, colon));
+        path.push_back(point);
+    }
+    std::sort(path.begin(), path.end(),
+        [](const PathPoint& a, const PathPoint& b) { return a.tick < b.tick; });
+    return !path.empty();
+}
+
+static bool parseBool(const std::string& text) {
+    return text == "1" || text == "true" || text == "yes" || text == "on";
+}
+
+bool loadScenario(const std::string& path, Scenario& scenario) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Could not open scenario " << path << std::endl;
+        return false;
+    }
+
+    scenario.name = path;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << path << ":" << lineNumber << ": expected key = value" << std::endl;
+            return false;
+        }
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        WorldConfig& world = scenario.world;
+
+        bool ok = true;
+        try {
+            if (key == "name") scenario.name = value;
+            else if (key == "seed") scenario.seed = world.seed = std::stoul(value);
+            else if (key == "ticks") scenario.ticks = std::stol(value);
+            else if (key == "dt") scenario.deltaTime = std::stof(value);
+            else if (key == "world_size") world.worldSize = std::stoi(value);
+            else if (key == "boxes") world.numBoxes = std::stoi(value);
+            else if (key == "box_max_size") world.boxMaxSize = std::stof(value);
+            else if (key == "asteroids") world.numAsteroids = std::stoi(value);
+            else if (key == "stars") world.numStars = std::stoi(value);
+            else if (key == "boids") world.initialBoids = std::stoi(value);
+            else if (key == "max_boids") world.maxBoids = std::stoi(value);
+            else if (key == "spawn") ok = parseSpawnCurve(value, world.spawnCurve);
+            else if (key == "player_start") ok = parseVec3(value, world.playerStart);
+            else if (key == "invulnerable") world.invulnerable = parseBool(value);
+            else if (key == "streaming") world.streaming = parseBool(value);
+            else if (key == "chunk_size") world.chunks.size = std::stof(value);
+            else if (key == "chunk_radius") world.chunks.loadRadius = std::stoi(value);
+            else if (key == "chunk_boxes") world.chunks.boxes = std::stoi(value);
+            else if (key == "chunk_asteroids") world.chunks.asteroids = std::stoi(value);
+            else if (key == "chunk_stars") world.chunks.stars = std::stoi(value);
+            else if (key == "chunk_budget_mb") world.chunks.budgetBytes = size_t(std::stod(value) * (1 << 20));
+            else if (key == "chunk_threads") world.chunks.threads = std::stoi(value);
+            else if (key == "chunk_latency") world.chunks.latency = std::stoi(value);
+            else if (key == "chunk_store") world.chunks.storePath = value;
+            else if (key == "path") ok = parsePath(value, scenario.path);
+            else if (key == "shoot_every") scenario.shootEvery = std::stoi(value);
+            else if (key == "checksum") scenario.checksum = value;
+            else {
+                std::cerr << path << ":" << lineNumber << ": unknown key " << key << std::endl;
+                return false;
+            }
+        } catch (const std::exception&) {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << path << ":" << lineNumber << ": bad value for " << key << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static glm::vec3 pathPosition(const std::vector<PathPoint>& path, long int tick) {
+    if (tick <= path.front().tick)
+        return path.front().position;
+    for (size_t i = 1; i < path.size(); i++) {
+        if (tick < path[i].tick) {
+            float t = float(tick - path[i - 1].tick) / float(path[i].tick - path[i - 1].tick);
+            return glm::mix(path[i - 1].position, path[i].position, t);
+        }
+    }
+    return path.back().position;
+}
+
+PlayerInput scriptedInput(const Scenario& scenario, const World& world, long int tick) {
+    PlayerInput input;
+    input.deltaTime = scenario.deltaTime;
+    input.shoot = scenario.shootEvery > 0 && tick % scenario.shootEvery == 0;
+    if (scenario.path.empty())
+        return input;
+
+    glm::vec3 toTarget = pathPosition(scenario.path, tick) - world.player.getPos();
+    float distance = glm::length(toTarget);
+    if (distance < 0.5f) {
+        input.stop = true;
+        return input;
+    }
+
+    // Invert cameraFrontFromAngles so "forward" points at the target
+    glm::vec3 heading = toTarget / distance;
+    input.pitch = glm::clamp(glm::degrees(std::asin(glm::clamp(-heading.y, -1.0f, 1.0f))), -89.0f, 89.0f);
+    input.yaw = glm::degrees(std::atan2(-heading.z, -heading.x));
+    input.forward = true;
+    input.boost = distance > 10.0f;
+    return input;
+}
@@ -0,0 +1,398 @@
+#include "utils/snapshot.h"
+#include <fstream>
+#include <iterator>
+
+#include "utils/lz.h"
+#include "utils/random.h"
+#include "utils/profiler.h"
+
+
+// Stored as raw bytes, their layout has to match between save and restore
+static_assert(std::is_trivially_copyable<Boid>::value, "boids are snapshotted as raw bytes");
+static_assert(std::is_trivially_copyable<Collectible>::value, "collectibles are snapshotted as raw bytes");
+static_assert(std::is_trivially_copyable<Planet>::value, "planets are snapshotted as raw bytes");
+
+static uint32_t layoutHash() {
+    return static_cast<uint32_t>(mix64(sizeof(Boid) | sizeof(Collectible) << 16 | uint64_t(sizeof(Planet)) << 32));
+}
+
+static uint64_t fnv1a(const uint8_t* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void putCell(SnapshotOut& out, const std::tuple<int,int,int>& cell) {
+    out.put(std::get<0>(cell));
+    out.put(std::get<1>(cell));
+    out.put(std::get<2>(cell));
+}
+
+static bool getCell(SnapshotIn& in, std::tuple<int,int,int>& cell) {
+    in.get(std::get<0>(cell));
+    in.get(std::get<1>(cell));
+    return in.get(std::get<2>(cell));
+}
+
+// Keys with a tick each, the streamer's loaded and pending chunks
+static void putChunks(SnapshotOut& out, const std::vector<std::pair<chunk_key_t, long int>>& chunks) {
+    out.put(static_cast<uint32_t>(chunks.size()));
+    for (const auto& [key, tick] : chunks) {
+        putCell(out, key);
+        out.put(tick);
+    }
+}
+
+static bool getChunks(SnapshotIn& in, std::vector<std::pair<chunk_key_t, long int>>& chunks) {
+    uint32_t count = 0;
+    in.get(count);
+    for (uint32_t i = 0; i < count && in.good(); i++) {
+        chunk_key_t key;
+        long int tick = 0;
+        getCell(in, key);
+        if (!in.get(tick))
+            break;
+        chunks.emplace_back(key, tick);
+    }
+    return in.good();
+}
+
+void SnapshotAccess::writePlayer(SnapshotOut& out, const Player& player) {
+    out.put(player.speed);
+    out.put(player.maxSpeed);
+    out.put(player.size);
+    out.put(player.position);
+    out.put(player.direction);
+    out.put(player.force_direction);
+    out.put(player.aimerPos);
+    out.put(player.frames_since_shot);
+    out.put(player.shot_cooldown);
+    out.put(player.isOrbiting);
+    out.put(player.orbitPlanetPos);
+    out.put(player.orbitPlanetGravity);
+    out.put(player.orbitRange);
+    out.put(player.toOrbitPlanet);
+    out.put(player.shotRange);
+    out.put(player.shotAccuracy);
+
+    out.put(static_cast<uint32_t>(player.bullets.size()));
+    for (const Bullet& bullet : player.bullets) {
+        out.put(bullet.gone);
+        out.put(bullet.colorFade);
+        out.put(bullet.position);
+        out.put(bullet.direction);
+        out.put(bullet.maxDistance);
+        out.put(bullet.strength);
+        out.put(static_cast<uint32_t>(bullet.trail.size()));
+        out.bytes(bullet.trail.data(), bullet.trail.size() * sizeof(glm::vec3));
+    }
+}
+
+bool SnapshotAccess::readPlayer(SnapshotIn& in, Player& player) {
+    in.get(player.speed);
+    in.get(player.maxSpeed);
+    in.get(player.size);
+    in.get(player.position);
+    in.get(player.direction);
+    in.get(player.force_direction);
+    in.get(player.aimerPos);
+    in.get(player.frames_since_shot);
+    in.get(player.shot_cooldown);
+    in.get(player.isOrbiting);
+    in.get(player.orbitPlanetPos);
+    in.get(player.orbitPlanetGravity);
+    in.get(player.orbitRange);
+    in.get(player.toOrbitPlanet);
+    in.get(player.shotRange);
+    in.get(player.shotAccuracy);
+
+    uint32_t count = 0;
+    in.get(count);
+    player.bullets.clear();
+    for (uint32_t i = 0; i < count && in.good(); i++) {
+        Bullet bullet;
+        in.get(bullet.gone);
+        in.get(bullet.colorFade);
+        in.get(bullet.position);
+        in.get(bullet.direction);
+        in.get(bullet.maxDistance);
+        in.get(bullet.strength);
+        uint32_t trail = 0;
+        if (!in.get(trail))
+            break;
+        bullet.trail.resize(trail);
+        in.bytes(bullet.trail.data(), trail * sizeof(glm::vec3));
+        player.bullets.push_back(std::move(bullet));
+    }
+    return in.good();
+}
+
+std::vector<uint8_t> serializeWorld(const World& world) {
+    PROFILE_ZONE("serializeWorld");
+    std::vector<uint8_t> payload;
+    payload.reserve(4096 + world.num_boids * (sizeof(Boid) + 4));
+    SnapshotOut out(payload);
+
+    out.put(world.frame);
+    out.put(world.num_boids);
+    out.put(world.game_over);
+    out.put(world.next_boid_id);
+
+    SnapshotAccess::writePlayer(out, world.player);
+
+    // Cells as they are, the order of boids inside a cell feeds float sums
+    out.put(static_cast<uint32_t>(world.boid_map.size()));
+    for (const auto& [cell, boids] : world.boid_map) {
+        putCell(out, cell);
+        out.put(static_cast<uint32_t>(boids.size()));
+        out.bytes(boids.data(), boids.size() * sizeof(Boid));
+    }
+
+    out.put(static_cast<uint32_t>(world.collectibles.size()));
+    out.bytes(world.collectibles.data(), world.collectibles.size() * sizeof(Collectible));
+
+    out.put(static_cast<uint32_t>(world.planets.size()));
+    out.bytes(world.planets.data(), world.planets.size() * sizeof(Planet));
+
+    if (world.config.streaming) {
+        ChunkStreamerState state = world.chunks.getState();
+        out.put(state.has_center);
+        putCell(out, state.center);
+        putChunks(out, state.loaded);
+        putChunks(out, state.pending);
+    }
+    return payload;
+}
+
+SnapshotHeader snapshotHeader(const World& world) {
+    SnapshotHeader header = {};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.layout = layoutHash();
+    header.world_checksum = world.checksum();
+    header.seed = world.config.seed;
+    header.frame = world.frame;
+    return header;
+}
+
+std::vector<uint8_t> encodeSnapshot(SnapshotHeader header, const std::vector<uint8_t>& payload, bool compress) {
+    PROFILE_ZONE("encodeSnapshot");
+    header.raw_size = payload.size();
+    header.payload_hash = fnv1a(payload.data(), payload.size());
+
+    std::vector<uint8_t> file(sizeof(SnapshotHeader));
+    if (compress) {
+        lzCompress(payload.data(), payload.size(), file);
+        // Stored raw when compressing does not pay
+        if (file.size() - sizeof(SnapshotHeader) >= payload.size())
+            compress = false;
+    }
+    if (!compress) {
+        file.resize(sizeof(SnapshotHeader));
+        file.insert(file.end(), payload.begin(), payload.end());
+    }
+    header.flags = compress ? SNAPSHOT_COMPRESSED : 0;
+    header.stored_size = file.size() - sizeof(SnapshotHeader);
+    std::memcpy(file.data(), &header, sizeof(header));
+    return file;
+}
+
+static bool writeFile(const std::string& path, const std::vector<uint8_t>& file, std::string& error) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(file.data()), file.size());
+    if (!out) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool saveSnapshot(const World& world, const std::string& path, bool compress, std::string& error) {
+    return writeFile(path, encodeSnapshot(snapshotHeader(world), serializeWorld(world), compress), error);
+}
+
+bool restoreSnapshot(World& world, const std::string& path, std::string& error) {
+    PROFILE_ZONE("restoreSnapshot");
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "could not open " + path;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    SnapshotHeader header;
+    if (data.size() < sizeof(header)) {
+        error = path + " is too small to be a snapshot";
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC) {
+        error = path + " is not a snapshot";
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION || header.layout != layoutHash()) {
+        error = path + " was saved by another build";
+        return false;
+    }
+    if (header.seed != world.config.seed) {
+        error = path + " was saved from seed " + std::to_string(header.seed)
+            + ", the world has " + std::to_string(world.config.seed);
+        return false;
+    }
+    if (header.stored_size != data.size() - sizeof(header)) {
+        error = path + " is truncated";
+        return false;
+    }
+
+    const uint8_t* stored = data.data() + sizeof(header);
+    std::vector<uint8_t> payload;
+    if (header.flags & SNAPSHOT_COMPRESSED) {
+        payload.resize(header.raw_size);
+        if (!lzDecompress(stored, header.stored_size, payload.data(), payload.size())) {
+            error = path + " does not decompress";
+            return false;
+        }
+    } else {
+        payload.assign(stored, stored + header.stored_size);
+    }
+    if (fnv1a(payload.data(), payload.size()) != header.payload_hash) {
+        error = path + " is corrupt, the payload hash does not match";
+        return false;
+    }
+
+    // Parsed into temporaries first so a bad payload leaves the world untouched.
+    // The checksum can only be taken once it is applied, see below.
+    SnapshotIn in(payload.data(), payload.size());
+    long int frame = 0;
+    int num_boids = 0;
+    bool game_over = false;
+    unsigned long next_id = 0;
+    in.get(frame);
+    in.get(num_boids);
+    in.get(game_over);
+    in.get(next_id);
+
+    Player player = world.player;
+    SnapshotAccess::readPlayer(in, player);
+
+    std::unordered_map<std::tuple<int,int,int>, std::vector<Boid>> boid_map;
+    uint32_t cells = 0;
+    in.get(cells);
+    for (uint32_t i = 0; i < cells && in.good(); i++) {
+        std::tuple<int,int,int> cell;
+        uint32_t count = 0;
+        getCell(in, cell);
+        if (!in.get(count) || count > payload.size() / sizeof(Boid))
+            break;
+        std::vector<Boid>& boids = boid_map[cell];
+        boids.resize(count, Boid(0, glm::vec3(0.0f), 0));
+        in.bytes(boids.data(), count * sizeof(Boid));
+    }
+
+    uint32_t count = 0;
+    std::vector<Collectible> collectibles;
+    if (in.get(count) && count <= payload.size() / sizeof(Collectible)) {
+        collectibles.resize(count, Collectible(0.0f, glm::vec3(0.0f), SPEED));
+        in.bytes(collectibles.data(), count * sizeof(Collectible));
+    }
+    std::vector<Planet> planets;
+    if (in.get(count) && count <= payload.size() / sizeof(Planet)) {
+        planets.resize(count, Planet(0.0f, glm::vec3(0.0f)));
+        in.bytes(planets.data(), count * sizeof(Planet));
+    }
+    ChunkStreamerState chunkState;
+    if (world.config.streaming) {
+        in.get(chunkState.has_center);
+        getCell(in, chunkState.center);
+        getChunks(in, chunkState.loaded);
+        getChunks(in, chunkState.pending);
+    }
+    if (!in.good() || !in.atEnd()) {
+        error = path + " has a malformed payload";
+        return false;
+    }
+
+    world.frame = frame;
+    world.num_boids = num_boids;
+    world.game_over = game_over;
+    world.shot_fired = false;
+    world.player = std::move(player);
+    world.boid_map = std::move(boid_map);
+    world.collectibles = std::move(collectibles);
+    world.planets = std::move(planets);
+    world.next_boid_id = next_id;
+    if (world.config.streaming) {
+        world.chunks.setState(chunkState, world.box_map, world.obstacle_field, world.evicted_obstacles);
+        world.space.setStars(world.chunks.collectStars());
+    }
+
+    // Too late to back out, the world now holds the restored state
+    if (world.checksum() != header.world_checksum) {
+        error = path + " restored to a different state, the world config does not match the one it was saved from";
+        return false;
+    }
+    return true;
+}
+
+SnapshotSaver::SnapshotSaver() : worker(&SnapshotSaver::workerLoop, this) {}
+
+SnapshotSaver::~SnapshotSaver() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void SnapshotSaver::save(const World& world, const std::string& path, bool compress) {
+    PROFILE_ZONE("SnapshotSaver::save");
+    Job job{path, serializeWorld(world), snapshotHeader(world), compress};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_all();
+}
+
+bool SnapshotSaver::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&] { return jobs.empty() && !busy; });
+    bool ok = !failed;
+    failed = false;
+    return ok;
+}
+
+std::string SnapshotSaver::getError() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+void SnapshotSaver::workerLoop() {
+    profilerSetThreadName("snapshots");
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        // Queued saves still go out when stopping
+        wake.wait(lock, [&] { return stopping || !jobs.empty(); });
+        if (jobs.empty())
+            return;
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        busy = true;
+        lock.unlock();
+
+        std::string jobError;
+        bool ok = writeFile(job.path, encodeSnapshot(job.header, job.payload, job.compress), jobError);
+
+        lock.lock();
+        busy = false;
+        if (!ok) {
+            failed = true;
+            error = jobError;
+        }
+        idle.notify_all();
+    }
+}
@@ -0,0 +1,293 @@
+#include "utils/texture_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "utils/asset_archive.h"
+#include "utils/profiler.h"
+
+
+static_assert(sizeof(TextureFileHeader) == 32 + TEXTURE_MAX_LEVELS * 24, "header layout is part of the file format");
+
+const char* textureFormatName(texture_format_t format) {
+    switch (format) {
+        case TEXTURE_RGB8:  return "rgb8";
+        case TEXTURE_RGBA8: return "rgba8";
+        case TEXTURE_BC1:   return "bc1";
+        default:            return "unknown";
+    }
+}
+
+static size_t alignUp(size_t offset) {
+    return (offset + 15) & ~size_t(15);
+}
+
+static size_t levelBytes(texture_format_t format, uint32_t width, uint32_t height) {
+    if (format == TEXTURE_BC1)
+        return size_t((width + 3) / 4) * ((height + 3) / 4) * 8;
+    return size_t(width) * height * (format == TEXTURE_RGBA8 ? 4 : 3);
+}
+
+// Box filtered half size, the last row or column repeats for odd sizes
+static std::vector<uint8_t> downsample(const std::vector<uint8_t>& pixels, int width, int height, int channels,
+        int& outWidth, int& outHeight) {
+    outWidth = std::max(width / 2, 1);
+    outHeight = std::max(height / 2, 1);
+    std::vector<uint8_t> out(size_t(outWidth) * outHeight * channels);
+    for (int y = 0; y < outHeight; y++) {
+        int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for (int x = 0; x < outWidth; x++) {
+            int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < channels; c++) {
+                int sum = pixels[(size_t(y0) * width + x0) * channels + c] + pixels[(size_t(y0) * width + x1) * channels + c]
+                    + pixels[(size_t(y1) * width + x0) * channels + c] + pixels[(size_t(y1) * width + x1) * channels + c];
+                out[(size_t(y) * outWidth + x) * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return out;
+}
+
+static uint16_t pack565(const int* rgb) {
+    return static_cast<uint16_t>((rgb[0] * 31 + 127) / 255 << 11 | (rgb[1] * 63 + 127) / 255 << 5 | (rgb[2] * 31 + 127) / 255);
+}
+
+static void unpack565(uint16_t color, int* rgb) {
+    int r = color >> 11 & 31, g = color >> 5 & 63, b = color & 31;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+}
+
+// Endpoints on the block's bounding box diagonal that follows the colors,
+// pulled in a little so the two interpolated colors land on real pixels
+static void encodeBlock(const uint8_t block[16][3], uint8_t* out) {
+    int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0}, mean[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            lo[c] = std::min<int>(lo[c], block[i][c]);
+            hi[c] = std::max<int>(hi[c], block[i][c]);
+            mean[c] += block[i][c];
+        }
+    }
+    // Green and blue run against red when they correlate negatively
+    long covariance[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        int dr = block[i][0] * 16 - mean[0];
+        covariance[1] += long(dr) * (block[i][1] * 16 - mean[1]);
+        covariance[2] += long(dr) * (block[i][2] * 16 - mean[2]);
+    }
+    for (int c = 1; c < 3; c++) {
+        if (covariance[c] < 0)
+            std::swap(lo[c], hi[c]);
+    }
+    for (int c = 0; c < 3; c++) {
+        int inset = (hi[c] - lo[c]) / 16;
+        hi[c] -= inset;
+        lo[c] += inset;
+    }
+
+    uint16_t c0 = pack565(hi), c1 = pack565(lo);
+    if (c0 < c1)
+        std::swap(c0, c1);
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        // Four color mode needs c0 > c1, palette 0, 1, 2/3 0 + 1/3 1, 1/3 0 + 2/3 1
+        int palette[4][3];
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestDistance = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = block[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= uint32_t(best) << (2 * i);
+        }
+    }
+    std::memcpy(out, &c0, 2);
+    std::memcpy(out + 2, &c1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+static void compressBC1(const std::vector<uint8_t>& pixels, int width, int height, uint8_t* out) {
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            uint8_t block[16][3];
+            // Blocks hanging over the edge repeat the last pixels
+            for (int i = 0; i < 16; i++) {
+                int x = std::min(bx + i % 4, width - 1);
+                int y = std::min(by + i / 4, height - 1);
+                std::memcpy(block[i], &pixels[(size_t(y) * width + x) * 3], 3);
+            }
+            encodeBlock(block, out);
+            out += 8;
+        }
+    }
+}
+
+std::vector<uint8_t> bakeTexture(const uint8_t* pixels, int width, int height, int channels, bool compress,
+        uint64_t sourceSize, int64_t sourceMtime) {
+    PROFILE_ZONE("bakeTexture");
+    TextureFileHeader header = {};
+    header.magic = TEXTURE_FILE_MAGIC;
+    header.version = TEXTURE_FILE_VERSION;
+    header.format = channels == 4 ? TEXTURE_RGBA8 : (compress ? TEXTURE_BC1 : TEXTURE_RGB8);
+    header.source_size = sourceSize;
+    header.source_mtime = sourceMtime;
+    texture_format_t format = static_cast<texture_format_t>(header.format);
+
+    std::vector<uint8_t> file(alignUp(sizeof(header)));
+    std::vector<uint8_t> level(pixels, pixels + size_t(width) * height * channels);
+    int w = width, h = height;
+    for (;;) {
+        TextureLevel& entry = header.level[header.levels++];
+        entry.width = w;
+        entry.height = h;
+        entry.offset = file.size();
+        entry.bytes = levelBytes(format, w, h);
+        file.resize(alignUp(entry.offset + entry.bytes));
+        if (format == TEXTURE_BC1)
+            compressBC1(level, w, h, file.data() + entry.offset);
+        else
+            std::memcpy(file.data() + entry.offset, level.data(), entry.bytes);
+        if ((w == 1 && h == 1) || header.levels == TEXTURE_MAX_LEVELS)
+            break;
+        level = downsample(level, w, h, channels, w, h);
+    }
+    std::memcpy(file.data(), &header, sizeof(header));
+    return file;
+}
+
+bool TextureFile::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        error = file.getError();
+        return false;
+    }
+    base = reinterpret_cast<const uint8_t*>(file.data());
+    if (!validate(file.size())) {
+        error = path + " " + error;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TextureFile::adopt(std::vector<uint8_t> data) {
+    close();
+    memory = std::move(data);
+    base = memory.data();
+    if (!validate(memory.size())) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TextureFile::close() {
+    file.close();
+    memory.clear();
+    base = nullptr;
+    header = nullptr;
+}
+
+bool TextureFile::validate(size_t size) {
+    const TextureFileHeader* candidate = reinterpret_cast<const TextureFileHeader*>(base);
+    if (size < sizeof(TextureFileHeader) || candidate->magic != TEXTURE_FILE_MAGIC) {
+        error = "is not a baked texture";
+        return false;
+    }
+    if (candidate->version != TEXTURE_FILE_VERSION || candidate->format >= TEXTURE_FORMAT_COUNT
+            || candidate->levels == 0 || candidate->levels > TEXTURE_MAX_LEVELS) {
+        error = "is from another version";
+        return false;
+    }
+    texture_format_t format = static_cast<texture_format_t>(candidate->format);
+    for (uint32_t i = 0; i < candidate->levels; i++) {
+        const TextureLevel& level = candidate->level[i];
+        if (level.bytes != levelBytes(format, level.width, level.height) || level.offset + level.bytes > size) {
+            error = "is truncated";
+            return false;
+        }
+    }
+    header = candidate;
+    return true;
+}
+
+size_t TextureFile::gpuBytes() const {
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < header->levels; i++) {
+        bytes += header->level[i].bytes;
+    }
+    return bytes;
+}
+
+static std::string cachePath(const std::string& dir, const std::string& imagePath, bool compress) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : imagePath) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx%s.btex", static_cast<unsigned long long>(hash), compress ? "c" : "");
+    return dir + "/" + name;
+}
+
+bool openCachedTexture(const std::string& dir, const std::string& imagePath, bool compress,
+        texture_decoder_t decode, TextureFile& texture) {
+    PROFILE_ZONE("openCachedTexture");
+    std::error_code failed;
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    // A packed image is stamped with its content hash, there is no mtime
+    AssetView packed = findAsset(imagePath);
+    if (packed) {
+        sourceSize = packed.size;
+        sourceMtime = static_cast<int64_t>(packed.hash);
+    } else {
+        sourceSize = std::filesystem::file_size(imagePath, failed);
+        if (!failed)
+            sourceMtime = std::filesystem::last_write_time(imagePath, failed).time_since_epoch().count();
+    }
+    bool haveSource = !failed;
+
+    std::string path = cachePath(dir, imagePath, compress);
+    if (texture.open(path)) {
+        const TextureFileHeader& header = texture.getHeader();
+        // Without the image there is nothing to rebake from, the baked copy is all there is
+        if (!haveSource || (header.source_size == sourceSize && header.source_mtime == sourceMtime))
+            return true;
+    }
+    if (!haveSource)
+        return false;
+
+    std::vector<uint8_t> pixels;
+    int width = 0, height = 0, channels = 0;
+    if (!decode(imagePath.c_str(), pixels, width, height, channels) || (channels != 3 && channels != 4))
+        return false;
+    std::vector<uint8_t> baked = bakeTexture(pixels.data(), width, height, channels, compress, sourceSize, sourceMtime);
+
+    // Written aside and renamed, another process never maps half a file
+    std::filesystem::create_directories(dir, failed);
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(baked.data()), baked.size());
+    }
+    std::filesystem::rename(temp, path, failed);
+    return texture.adopt(std::move(baked));
+}
@@ -0,0 +1,146 @@
+#include "utils/timer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#define STATS_HISTOGRAM_BASE_MS 0.1
+#define STATS_MAX_HITCHES 1024
+
+
+FrameStats::FrameStats(size_t window_, double hitchMs_)
+    : window(std::max<size_t>(window_, 1)), hitchMs(hitchMs_) {
+    samples.reserve(window);
+}
+
+static int bucketOf(double ms) {
+    if (ms < STATS_HISTOGRAM_BASE_MS)
+        return 0;
+    int bucket = static_cast<int>(4.0 * std::log2(ms / STATS_HISTOGRAM_BASE_MS));
+    return std::min(bucket, STATS_HISTOGRAM_BUCKETS - 1);
+}
+
+double FrameStats::bucketLower(int bucket) {
+    if (bucket <= 0)
+        return 0.0;
+    return STATS_HISTOGRAM_BASE_MS * std::exp2(bucket / 4.0);
+}
+
+void FrameStats::add(double ms) {
+    if (samples.size() < window) {
+        samples.push_back(ms);
+    } else {
+        samples[next] = ms;
+    }
+    next = (next + 1) % window;
+
+    histogram[bucketOf(ms)]++;
+    if (ms > hitchMs) {
+        hitch_count++;
+        if (hitches.size() < STATS_MAX_HITCHES)
+            hitches.push_back({count, ms});
+    }
+    count++;
+}
+
+StatsSummary FrameStats::summary() const {
+    StatsSummary s = {0, 0, 0, 0, 0};
+    if (samples.empty())
+        return s;
+
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    // Nearest rank, the same definition boids_scenario uses
+    auto rank = [&](double p) {
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    };
+    double sum = 0.0;
+    for (double ms : sorted) {
+        sum += ms;
+    }
+    s.p50 = rank(0.50);
+    s.p95 = rank(0.95);
+    s.p99 = rank(0.99);
+    s.max = sorted.back();
+    s.mean = sum / sorted.size();
+    return s;
+}
+
+void FrameStats::writeCsv(std::ostream& out) const {
+    out << "lower_ms,upper_ms,count\n";
+    for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        out << bucketLower(b) << ",";
+        if (b + 1 < STATS_HISTOGRAM_BUCKETS)
+            out << bucketLower(b + 1);
+        out << "," << histogram[b] << "\n";
+    }
+}
+
+void FrameStats::writeJson(std::ostream& out) const {
+    StatsSummary s = summary();
+    out << "{\n"
+        << "  \"frames\": " << count << ",\n"
+        << "  \"window\": " << samples.size() << ",\n"
+        << "  \"p50_ms\": " << s.p50 << ",\n"
+        << "  \"p95_ms\": " << s.p95 << ",\n"
+        << "  \"p99_ms\": " << s.p99 << ",\n"
+        << "  \"max_ms\": " << s.max << ",\n"
+        << "  \"mean_ms\": " << s.mean << ",\n"
+        << "  \"hitch_threshold_ms\": " << hitchMs << ",\n"
+        << "  \"hitch_count\": " << hitch_count << ",\n"
+        << "  \"hitches\": [";
+    for (size_t i = 0; i < hitches.size(); i++) {
+        out << (i == 0 ? "" : ", ") << "{\"frame\": " << hitches[i].frame << ", \"ms\": " << hitches[i].ms << "}";
+    }
+    out << "],\n  \"histogram\": [";
+    bool first = true;
+    for (int b = 0; b < STATS_HISTOGRAM_BUCKETS; b++) {
+        if (histogram[b] == 0)
+            continue;
+        out << (first ? "" : ", ") << "{\"lower_ms\": " << bucketLower(b) << ", \"count\": " << histogram[b] << "}";
+        first = false;
+    }
+    out << "]\n}\n";
+}
+
+Timer::Timer(double hitchMs, size_t window) : stats(window, hitchMs) {
+    start();
+}
+
+void Timer::record() {
+    num_frames++;
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    game_time += elapsed.count();
+    frame_rate = game_time / num_frames;
+    stats.add(elapsed.count() * 1000.0);
+    start_time = end_time;
+
+    // Printing every frame showed up in the frame time itself
+    since_report += elapsed.count();
+    if (since_report >= 1.0) {
+        since_report = 0.0;
+        StatsSummary s = stats.summary();
+        std::printf("\rFrame ms p50 %.2f p95 %.2f p99 %.2f max %.2f, hitches %ld    ",
+            s.p50, s.p95, s.p99, s.max, stats.getHitchCount());
+        std::fflush(stdout);
+    }
+}
+
+bool Timer::writeCsv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    stats.writeCsv(out);
+    return static_cast<bool>(out);
+}
+
+bool Timer::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    stats.writeJson(out);
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,376 @@
+#include "utils/world.h"
+#include <algorithm>
+#include <cmath>
+
+#include "algorithm/flock.h"
+#include "utils/random.h"
+#include "utils/profiler.h"
+#include "utils/counters.h"
+
+
+const char* worldPhaseName(world_phase_t phase) {
+    switch (phase) {
+        case PHASE_INPUT:        return "input";
+        case PHASE_CHUNKS:       return "chunks";
+        case PHASE_SPAWN:        return "spawn";
+        case PHASE_CELLS:        return "recalculateCells";
+        case PHASE_FLOCKS:       return "getCenter";
+        case PHASE_BOIDS:        return "boids";
+        case PHASE_COLLECTIBLES: return "collectibles";
+        case PHASE_OBSTACLES:    return "obstacles";
+        case PHASE_PLANETS:      return "planets";
+        case PHASE_PLAYER:       return "player";
+        default:                 return "unknown";
+    }
+}
+
+glm::vec3 cameraFrontFromAngles(float yaw, float pitch) {
+    // The camera orbits the player, so it looks back along the orbit direction
+    return -glm::vec3(
+        cos(glm::radians(pitch)) * cos(glm::radians(yaw)),
+        sin(glm::radians(pitch)),
+        cos(glm::radians(pitch)) * sin(glm::radians(yaw)));
+}
+
+// The streamer's config as the world uses it: nothing spawns on the player and
+// no threads are started for a world that does not stream
+static ChunkConfig streamerConfig(const WorldConfig& config) {
+    ChunkConfig chunks = config.chunks;
+    chunks.clearCenter = config.playerStart;
+    if(!config.streaming)
+      chunks.threads = 0;
+    return chunks;
+}
+
+World::World(const WorldConfig& config_)
+    : config(config_),
+      player(0.15f, config_.playerStart),
+      box_map(config_.streaming
+          ? std::unordered_map<std::tuple<int,int,int>, std::vector<Obstacle*>>()
+          : generateRandomBoxes(config_.numBoxes, config_.boxMaxSize, config_.worldSize, config_.seed)),
+      space(config_.starsRadius, config_.asteroidsRadius,
+          config_.streaming ? 0 : config_.numStars, config_.streaming ? 0 : config_.numAsteroids,
+          config_.playerStart, box_map, config_.seed),
+      chunks(streamerConfig(config_), config_.seed),
+      goal_visibility(obstacle_field) {
+
+    if(config.streaming){
+      // Waits for the chunks in range so the first boids see their obstacles
+      chunks.update(player.getPos(), frame, true, box_map, obstacle_field, evicted_obstacles);
+      space.setStars(chunks.collectStars());
+    } else {
+      // Bake obstacle distances once the boxes and asteroids are all placed
+      obstacle_field.build(box_map);
+    }
+
+    // Keyed as tick -1 so the first step's spawns draw different positions
+    generateRandomBoids(boid_map, config.initialBoids, config.worldSize, box_map, -1, player.getPos(), config.seed, next_boid_id);
+
+    Planet sun(30.0f, glm::vec3(0.0f,0.0f,0.0f), 2.5f);
+    Planet earth(20.0f, glm::vec3(0.0f,0.0f,0.0f), 2.5f);
+    Planet moon(2.0f, glm::vec3(0.0f,0.0f,0.0f), 0.1f);
+
+    earth.orbit(200.0f, 0.01f);
+    moon.orbit(10.0f, 0.05f);
+
+    planets.push_back(sun);
+    planets.push_back(earth);
+    planets.push_back(moon);
+}
+
+World::~World() {
+    for (auto& [cell, obstacles] : box_map) {
+      for (Obstacle* obstacle : obstacles) {
+        delete obstacle;
+      }
+    }
+}
+
+// 64 bit FNV-1a, fed field by field so padding never gets hashed
+static void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+static void hashVec3(uint64_t& hash, const glm::vec3& v) {
+    hashBytes(hash, &v.x, sizeof(float));
+    hashBytes(hash, &v.y, sizeof(float));
+    hashBytes(hash, &v.z, sizeof(float));
+}
+
+uint64_t World::checksum() const {
+    uint64_t hash = 14695981039346656037ULL;
+    hashBytes(hash, &frame, sizeof(frame));
+    hashBytes(hash, &num_boids, sizeof(num_boids));
+    hashBytes(hash, &game_over, sizeof(game_over));
+
+    hashVec3(hash, player.getPos());
+    hashVec3(hash, player.getDirection());
+    hashBytes(hash, &player.speed, sizeof(player.speed));
+
+    // Cell iteration order is not stable between runs, ids are
+    std::vector<const Boid*> boids;
+    for (const auto& [cell, cell_boids] : boid_map) {
+      for (const Boid& boid : cell_boids) {
+        boids.push_back(&boid);
+      }
+    }
+    std::sort(boids.begin(), boids.end(),
+        [](const Boid* a, const Boid* b) { return a->getId() < b->getId(); });
+    for (const Boid* boid : boids) {
+      unsigned long id = boid->getId();
+      hashBytes(hash, &id, sizeof(id));
+      hashVec3(hash, boid->getPos());
+      hashVec3(hash, boid->getDirection());
+    }
+
+    for (const Bullet& bullet : player.getBullets()) {
+      uint32_t trail = static_cast<uint32_t>(bullet.getTrail().size());
+      hashBytes(hash, &bullet.gone, sizeof(bullet.gone));
+      hashBytes(hash, &bullet.colorFade, sizeof(bullet.colorFade));
+      hashVec3(hash, bullet.getPos());
+      hashBytes(hash, &trail, sizeof(trail));
+    }
+
+    for (const Collectible& c : collectibles) {
+      benefit_t benefit = c.getBenefit();
+      hashVec3(hash, c.getPos());
+      hashBytes(hash, &benefit, sizeof(benefit));
+    }
+    for (const Planet& planet : planets) {
+      hashVec3(hash, planet.getPos());
+    }
+
+    // Obstacles by their bounds, an obstacle spanning cells is in box_map more than once
+    std::vector<const Obstacle*> obstacles;
+    for (const auto& [cell, cell_obstacles] : box_map) {
+      obstacles.insert(obstacles.end(), cell_obstacles.begin(), cell_obstacles.end());
+    }
+    std::sort(obstacles.begin(), obstacles.end());
+    obstacles.erase(std::unique(obstacles.begin(), obstacles.end()), obstacles.end());
+    std::vector<std::tuple<float,float,float,float,float,float>> bounds;
+    for (const Obstacle* obstacle : obstacles) {
+      bounds.emplace_back(obstacle->getMinX(), obstacle->getMinY(), obstacle->getMinZ(),
+          obstacle->getMaxX(), obstacle->getMaxY(), obstacle->getMaxZ());
+    }
+    std::sort(bounds.begin(), bounds.end());
+    for (const auto& [minX, minY, minZ, maxX, maxY, maxZ] : bounds) {
+      hashVec3(hash, glm::vec3(minX, minY, minZ));
+      hashVec3(hash, glm::vec3(maxX, maxY, maxZ));
+    }
+    return hash;
+}
+
+int World::spawnCount() {
+    if(config.spawnCurve.empty())
+      return shouldSpawnBoid(frame, config.seed) ? 1 : 0;
+
+    // Piecewise linear in ticks, flat before the first and after the last point
+    const std::vector<SpawnPoint>& curve = config.spawnCurve;
+    float rate = curve.back().rate;
+    if(frame <= curve.front().tick){
+      rate = curve.front().rate;
+    } else {
+      for(size_t i = 1; i < curve.size(); i++){
+        if(frame < curve[i].tick){
+          float t = float(frame - curve[i - 1].tick) / float(curve[i].tick - curve[i - 1].tick);
+          rate = glm::mix(curve[i - 1].rate, curve[i].rate, t);
+          break;
+        }
+      }
+    }
+
+    // Whole spawns always happen, the fraction is a chance for one more
+    int count = static_cast<int>(rate);
+    if(Rng(config.seed, RNG_SPAWN_CHANCE, 1, frame).chance(rate - count))
+      count++;
+    return count;
+}
+
+void World::hitPlayer() {
+    if(!config.invulnerable)
+      game_over = true;
+}
+
+void World::step(const PlayerInput& input) {
+    shot_fired = false;
+    evicted_obstacles.clear();
+    if(game_over)
+      return;
+    PROFILE_ZONE("World::step");
+    CounterSample counters_start = countersSnapshot();
+
+    // Phases run back to back, so each one is timed from the end of the last
+    // and also recorded as a profiler zone nested in World::step
+    bool profiling = profilerEnabled();
+    // Opened by the first step rather than the constructor, the counters
+    // follow the thread that opens them and the world may be built on a
+    // loader thread. A failed open leaves an error and is not retried,
+    // callers check perf.isOpen() and report perf.getError() themselves.
+    if(config.perfCounters && !perf.isOpen() && perf.getError().empty())
+      perf.open();
+    bool counting = perf.isOpen();
+    uint64_t last = profilerNow();
+    PerfSample last_counters = counting ? perf.read() : PerfSample();
+    auto endPhase = [&](world_phase_t phase) {
+      if(counting){
+        PerfSample counters = perf.read();
+        phase_counters[phase] = perfDelta(last_counters, counters);
+        last_counters = counters;
+      }
+      uint64_t now = profilerNow();
+      phase_seconds[phase] = (now - last) * 1e-9;
+      if(profiling)
+        profilerRecord(worldPhaseName(phase), last, now);
+      last = now;
+    };
+
+    glm::vec3 cameraFront = cameraFrontFromAngles(input.yaw, input.pitch);
+    glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
+
+    // Controls go in first so they move the player this step
+    float cameraSpeed = 2.5f * input.deltaTime;
+    if (input.boost)
+        cameraSpeed = 10.5f * input.deltaTime;
+    if (input.stop)
+        player.setSpeed(0.0f);
+    if (input.forward)
+        player.applyForce(cameraFront, cameraSpeed);
+    if (input.back)
+        player.applyForce(-cameraFront, cameraSpeed);
+    if (input.left)
+        player.applyForce(-glm::normalize(glm::cross(cameraFront, cameraUp)), cameraSpeed);
+    if (input.right)
+        player.applyForce(glm::normalize(glm::cross(cameraFront, cameraUp)), cameraSpeed);
+    if (input.up)
+        player.applyForce(cameraUp, cameraSpeed);
+    if (input.down)
+        player.applyForce(-cameraUp, cameraSpeed);
+    shot_fired = player.requestShot(input.shoot, boid_map);
+    endPhase(PHASE_INPUT);
+
+    if(config.streaming){
+      if(chunks.update(player.getPos(), frame, false, box_map, obstacle_field, evicted_obstacles))
+        space.setStars(chunks.collectStars());
+    }
+    endPhase(PHASE_CHUNKS);
+
+    int spawns = std::min(spawnCount(), config.maxBoids - num_boids);
+    generateRandomBoids(boid_map, spawns, 20.0f, box_map, frame, player.getPos(), config.seed, next_boid_id);
+    endPhase(PHASE_SPAWN);
+
+    boid_map = recalculateCells(std::move(boid_map), num_boids, cell_order, frame);
+    endPhase(PHASE_CELLS);
+
+    std::unordered_map<std::tuple<int, int, int>, glm::vec3> flock_map = getCenter(boid_map);
+    endPhase(PHASE_FLOCKS);
+
+    std::tuple<int, int, int> player_cell = positionToCell(player.getPos());
+    goal_visibility.update(player.getPos());
+    sensing.beginFrame();
+
+    // Walk cells in Morton order so neighboring cells are processed back to back
+    uint64_t cells_touched = 0, boids_killed = 0, far_flocks = 0, far_flock_boids = 0;
+    for(const std::tuple<int, int, int>& cell : cell_order.getCells()){
+      if(game_over)
+        break;
+      std::vector<Boid>& boids = boid_map[cell];
+      cells_touched++;
+
+      if(player_cell == cell){
+        for(Boid& b : boids){
+          if(b.contains(player.getPos())){
+            hitPlayer();
+          }
+        }
+      }
+
+      glm::vec3 cell_flock = flock_map[cell];
+      glm::vec3 cell_heading = getHeading(boids);
+      // Far cells clear of obstacles are one flock state, not per-boid updates
+      if(Boid::driftFlock(boids, player.getPos(), cell_heading, obstacle_field)){
+        far_flocks++;
+        far_flock_boids += boids.size();
+        continue;
+      }
+
+      for (size_t i = 0; i < boids.size(); i++) {
+        if(!boids[i].tick(frame,
+              player.getPos(),
+              obstacle_field,
+              goal_visibility,
+              sensing,
+              cell_flock,
+              cell_heading,
+              boids)){
+          Rng drop(config.seed, RNG_DROPS, boids[i].getId(), frame);
+          if(drop.chance(0.1f)){
+            collectibles.push_back(Collectible(0.05f, boids[i].getPos(),
+                  static_cast<benefit_t>(drop.range(SPEED, HEALTH))));
+          }
+          boids.erase(boids.begin() + i);
+          boids_killed++;
+          i--;
+          continue;
+        }
+      }
+    }
+    countEvent(COUNTER_CELLS_TOUCHED, cells_touched);
+    countEvent(COUNTER_BOIDS_KILLED, boids_killed);
+    countEvent(COUNTER_FAR_FLOCKS, far_flocks);
+    countEvent(COUNTER_FAR_FLOCK_BOIDS, far_flock_boids);
+    endPhase(PHASE_BOIDS);
+
+    for(size_t i = 0; i < collectibles.size(); i++){
+      Collectible& c = collectibles[i];
+      c.update();
+      if(c.gone){
+        collectibles.erase(collectibles.begin() + i);
+        i--;
+        continue;
+      }
+      if(c.contains(player.getPos())){
+        player.applyBenefit(c.collect());
+      }
+    }
+    endPhase(PHASE_COLLECTIBLES);
+
+    for (const auto& [cell, boxes] : box_map) {
+      countEvent(COUNTER_CONTAINS, boxes.size());
+      for (const Obstacle* box : boxes) {
+        if(box->contains(player.getPos())){
+          hitPlayer();
+        }
+      }
+    }
+    endPhase(PHASE_OBSTACLES);
+
+    Planet* last_planet = nullptr;
+    for(Planet& planet : planets){
+      if(last_planet != nullptr){
+        planet.updatePos(last_planet->getPos());
+      }
+      player.requestOrbit(planet.getPos(), planet.gravity * 20.0f);
+      if(planet.contains(player.getPos())){
+        hitPlayer();
+      }
+      last_planet = &planet;
+    }
+    endPhase(PHASE_PLANETS);
+
+    player.updatePos(cameraFront);
+    player.updateBullets();
+    endPhase(PHASE_PLAYER);
+
+    frame_counters = counterDelta(counters_start, countersSnapshot());
+    if(profiling){
+      for(int c = 0; c < COUNTER_COUNT; c++){
+        profilerCounter(counterName(static_cast<counter_t>(c)), last, frame_counters.values[c]);
+      }
+    }
+
+    frame++;
+}
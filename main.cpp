@@ -1,249 +1,267 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
-#include <unordered_map>
 #include <iostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include "utils/camera.h"
 #include <optional>
-#include "utils/m_shader.h"
-#include "utils/scene.h"
-#include "shapes/player.h"
-#include <ctime>
-#include <random>
-#include <queue>
-#include <vector>
-#include <cmath>
-#include <algorithm>
+#include <memory>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 #include <thread>
 #include <chrono>
+#include <random>
+#include <fstream>
+#include <cstring>
+#include <string>
 
 
+#include "utils/scene.h"
 #include "utils/timer.h"
-#include "shapes/sphere.h"
-#include "shapes/sun.h"
-#include "shapes/planet.h"
-#include "shapes/box.h"
-#include "shapes/boid.h"
-#include "shapes/space.h"
-#include "utils/generation.h"
 #include "utils/sound.h"
-#include "algorithm/flock.h"
-#include "shapes/collectible.h"
+#include "utils/world.h"
+#include "utils/profiler.h"
+#include "utils/snapshot.h"
+#include "utils/replay.h"
+#include "utils/loader.h"
+#include "render/world_renderer.h"
+#include "render/model.h"
+#include "render/hud.h"
+
 
 
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [WORLD] [--record PATH] [--replay PATH] [--assets PATH] [--asteroid-model PATH]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    uint64_t launch = profilerNow();
+    std::string storePath;
+    std::string recordPath;
+    std::string replayPath;
+    std::string assetsPath;
+    std::string asteroidModelPath;
+    for (int i = 1; i < argc; i++) {
+      bool hasValue = i + 1 < argc;
+      if (std::strcmp(argv[i], "--record") == 0 && hasValue) {
+        recordPath = argv[++i];
+      } else if (std::strcmp(argv[i], "--replay") == 0 && hasValue) {
+        replayPath = argv[++i];
+      } else if (std::strcmp(argv[i], "--assets") == 0 && hasValue) {
+        assetsPath = argv[++i];
+      } else if (std::strcmp(argv[i], "--asteroid-model") == 0 && hasValue) {
+        asteroidModelPath = argv[++i];
+      } else if (argv[i][0] != '-' && storePath.empty()) {
+        storePath = argv[i];
+      } else {
+        usage(argv[0]);
+        return 1;
+      }
+    }
+
+    // Packed assets from boids_pack, anything not in there is read from ../assets and ../shaders
+    if(!assetsPath.empty()){
+      if(!assetArchive().open(assetsPath))
+        std::cerr << "Assets: " << assetArchive().getError() << ", reading loose files instead" << std::endl;
+    } else {
+      assetArchive().open("boids_assets.pak");
+    }
+
+    // A fresh world every game, scenarios and replays pin the seed instead
+    WorldConfig config;
+    config.seed = std::random_device{}();
+    config.streaming = true;
+    // A baked world from boids_bake, chunks are read from it instead of
+    // generated. It is played with the seed it was baked from.
+    config.chunks.storePath = storePath;
+    if(!storePath.empty()){
+      ChunkStore store;
+      if(store.open(storePath))
+        config.seed = store.getHeader().seed;
+    }
+
+    ReplayReader replay;
+    bool replaying = !replayPath.empty();
+    if(replaying){
+      if(!replay.open(replayPath)){
+        std::cerr << "Replay: " << replay.getError() << std::endl;
+        return 1;
+      }
+      replay.apply(config);
+      if(!replay.checkStore(config)){
+        std::cerr << "Replay: " << replay.getError() << std::endl;
+        return 1;
+      }
+    }
 
-int main() {
     std::optional<GLFWwindow*> opt_window = init_scene();
     if(!opt_window.has_value()){
       return -1;
     }
     GLFWwindow* window = opt_window.value();
-
-
+    profilerSetThreadName("main");
+
+    // The progress screen needs the overlay's one small shader first
+    Hud hud;
+    int lazer = -1;
+    int explosion = -1;
+    TextureFile sunImage;
+    GLuint sunTexture = 0;
+    std::vector<GLfloat> asteroidVertices;
+    std::vector<GLuint> asteroidIndices;
+    std::vector<MeshLod> asteroidLods;
+    std::unique_ptr<World> loadedWorld;
+    std::unique_ptr<WorldRenderer> loadedRenderer;
+    // SDL is initialized on the main thread, the workers only decode into the
+    // device format it opened
     initMixer();
-    int lazer = loadSound("../assets/lazer.wav");
-    int explosion = loadSound("../assets/explosion.wav");
-
-    //std::this_thread::sleep_for(std::chrono::seconds(3));
-
-
-    Player player(0.15f, glm::vec3(100.0f,0.0f,0.0f));
-
-
-    int worldSize = 50;
-    std::unordered_map<std::tuple<int, int, int>, std::vector<Obstacle*>> box_map = generateRandomBoxes(10,1,worldSize);
-    std::unordered_map<std::tuple<int, int, int>, std::vector<Boid>> boid_map;
-    generateRandomBoids(boid_map, 20, worldSize, box_map, 0, player.getPos());
-    generateRandomBoids(boid_map, 20, worldSize, box_map, 0, player.getPos());
-    generateRandomBoids(boid_map, 20, worldSize, box_map, 0, player.getPos());
-
-    std::vector<Bullet> bullets;
-    std::vector<Collectible> collectibles;
-    GLuint asteroidTexture = loadTexture("../assets/asteroid.jpg");
-    GLuint sunTexture = loadTexture("../assets/sun.jpg");
-
-
-    Shader lightingShader("../shaders/shadow.vs", "../shaders/shadow.fs");
-    Shader textureShader("../shaders/texture.vs", "../shaders/texture.fs");
-    Shader brightShader("../shaders/1.colors.vs", "../shaders/1.colors.fs");
-
-    Space space(200.0f, 100.0f, 1000, 100, player.getPos(), box_map);
-
-    Planet sun(30.0f, glm::vec3(0.0f,0.0f,0.0f), 2.5f);
-
-    Planet earth(20.0f, glm::vec3(0.0f,0.0f,0.0f), 2.5f);
-    Planet moon(2.0f, glm::vec3(0.0f,0.0f,0.0f), 0.1f);
-
-    earth.orbit(200.0f, 0.01f);
-    moon.orbit(10.0f, 0.05f);
-
-    std::vector<Planet> planets;
-    planets.push_back(sun);
-    planets.push_back(earth);
-    planets.push_back(moon);
-
-    Timer timer;
+    {
+      // Decoding and world generation run on the workers while this thread
+      // compiles shaders and uploads whatever the workers finished
+      AsyncLoader loader(3);
+      loader.add("load world", 4.0f, [&]{ loadedWorld = std::make_unique<World>(config); });
+      loader.add("load sounds", 1.0f, [&]{
+        lazer = loadSound("../assets/lazer.wav");
+        explosion = loadSound("../assets/explosion.wav");
+      });
+      // Mapped from the texture cache, only the first run decodes the JPEG
+      loader.add("load sun texture", 2.0f,
+        [&]{ openTexture("../assets/sun.jpg", sunImage); },
+        [&]{ sunTexture = uploadTexture(sunImage); sunImage.close(); });
+      // Parsed and simplified once, later runs read the mesh cache
+      if(!asteroidModelPath.empty())
+        loader.add("load asteroid model", 1.0f,
+          [&]{ loadModel(asteroidVertices, asteroidIndices, asteroidModelPath, 1.0f, 1, &asteroidLods); });
+      // Only starts the compiles when the driver builds programs in parallel
+      loader.addMain("compile shaders", 2.0f, [&]{ loadedRenderer = std::make_unique<WorldRenderer>(0); });
+
+      // A few ms of main thread jobs per frame keeps the screen responsive
+      bool loaded = false;
+      while(!loaded && !glfwWindowShouldClose(window)){
+        loaded = loader.poll(8.0) && programCache().ready();
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        hud.drawProgress(loader.current().c_str(), loader.progress(), width, height);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+      }
+      if(!loaded){
+        // Closed while loading, the loader waits for the jobs already running
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+      }
+    }
+    programCache().finish();
+    std::cout << "Shaders: " << programCache().getHits() << " from the cache, "
+      << programCache().getMisses() << " compiled" << std::endl;
+    World& world = *loadedWorld;
+    WorldRenderer& renderer = *loadedRenderer;
+    renderer.setSunTexture(sunTexture);
+    if(!asteroidLods.empty())
+      renderer.setAsteroidModel(asteroidVertices, asteroidIndices, asteroidLods);
+    if(!storePath.empty() && !world.chunks.getStore().isOpen())
+      std::cerr << "Chunk store: " << world.chunks.getStore().getError() << ", generating chunks instead" << std::endl;
+    SnapshotSaver snapshots;
+    // With --record the session can be replayed with --replay, to chase a hitch seen in play
+    ReplayRecorder recorder;
+    if(!replaying && !recordPath.empty())
+      recorder.open(recordPath, config);
+    size_t replayTick = 0;
+
+    // Anything slower than 30 FPS is logged as a hitch
+    Timer timer(1000.0 / 30.0);
 
 
     glEnable(GL_DEPTH_TEST);
 
-    int num_boids = 0;
-
-
-
-    bool game_over = false;
-    while (!glfwWindowShouldClose(window) && !game_over) {
+    PlayerInput input;
+    bool firstFrame = true;
+    while (!glfwWindowShouldClose(window) && !world.game_over) {
+        if(replaying){
+          if(replayTick == replay.getInputs().size())
+            break;
+          input = replay.getInputs()[replayTick++];
+          // The camera follows the recorded one
+          yaw = input.yaw;
+          pitch = input.pitch;
+          radius = input.radius;
+        }
+        PROFILE_ZONE("frame");
         timer.start();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-
-        if(shouldSpawnBoid(timer.get_frame()) && num_boids < 200){
-          generateRandomBoids(boid_map, 1, 20.0f, box_map, timer.get_frame(), player.getPos());
-        }
-
-        boid_map = recalculateCells(boid_map, num_boids);
-
-
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        recorder.record(input);
+        world.step(input);
+        if(world.shot_fired){
+          playSound(lazer);
+        }
+
         glMatrixMode(GL_MODELVIEW);
         glLoadIdentity();
         glTranslatef(0.0f, 0.0f, -5.0f);
 
+        updateCamera(window, world.player.getPos());
 
         glm::mat4 projection = glm::perspective(
             glm::radians(45.0f),
             (float)width / (float)height, 0.1f, 1000.0f);
         view = glm::lookAt(cameraPos - glm::vec3(0.0f,0.2f,0.0f), cameraPos + cameraFront, cameraUp);
-        glm::mat4 model = glm::mat4(1.0f);
         glLoadMatrixf(glm::value_ptr(view));
 
-        updateCamera(window, player.getPos());
-
-
-        brightShader.use();
-        brightShader.setMat4("model", model);
-        brightShader.setMat4("projection", projection);
-        brightShader.setMat4("view", view);
-        brightShader.setVec3("lightColor",  1.0f, 1.0f, 1.0f);
-
-        //drawChunkBorders(box_map);
-
-
-        std::unordered_map<std::tuple<int, int, int>, glm::vec3> flock_map = getCenter(boid_map);
-
-        std::tuple<int, int, int> player_cell = positionToCell(player.getPos());
+        renderer.draw(world, view, projection, cameraPos);
+        hud.draw(world, timer, renderer.getGpuTimer(), width, height);
+        //drawChunkBorders(world.box_map);
 
-        for(auto& [cell, boids] : boid_map){
-          if(game_over)
-            break;
-
-          if(player_cell == cell){
-            for(Boid& b : boids){
-              if(b.contains(player.getPos())){
-                game_over = true;
-              }
-            }
-          }
-
-          glm::vec3 cell_flock = flock_map[cell];
-          std::vector<Obstacle*> cell_boxes = box_map[cell];
-
-          for (size_t i = 0; i < boids.size(); i++) {
-            if(!boids[i].act(player.getPos(),
-                  cell_boxes,
-                  cell_flock,
-                  boids)){
-              if(rand() % 10 == 0){
-                collectibles.push_back(Collectible(0.05f, boids[i].getPos()));
-              }
-              boids.erase(boids.begin() + i);
-            }
-            boids[i].draw(brightShader);
-          }
+        // Read after drawing, the next step applies it
+        input = processInput(window);
+        {
+          PROFILE_ZONE("swapBuffers");
+          glfwSwapBuffers(window);
         }
-
-        for(Collectible& c : collectibles){
-          c.draw(brightShader);
-          if(c.contains(player.getPos())){
-            benefit_t collected_benefit = c.collect();
-            player.applyBenefit(collected_benefit);
-          }
+        if(firstFrame){
+          // From process start to the first game frame on screen, loading screen included
+          uint64_t shown = profilerNow();
+          profilerRecord("time to first frame", launch, shown);
+          std::cout << "Time to first frame: " << (shown - launch) * 1e-6 << " ms" << std::endl;
+          firstFrame = false;
         }
-
-        textureShader.use();
-        textureShader.setMat4("model", model);
-        textureShader.setMat4("view", view);
-        textureShader.setMat4("projection", projection);
-        glBindTexture(GL_TEXTURE_2D, asteroidTexture);
-
-
-        space.render(brightShader, textureShader);
-
-
-        textureShader.use();
-        glBindTexture(GL_TEXTURE_2D, sunTexture);
-        sun.draw();
-
-        lightingShader.use();
-        lightingShader.setMat4("model", model);
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-        lightingShader.setVec3("cameraPos", cameraPos);
-        lightingShader.setVec3("objectColor", 0.0f, 1.0f, 1.0f);
-        lightingShader.setVec3("lightPos", sun.getPos());
-        lightingShader.setVec3("lightColor",  1.0f, 1.0f, 0.75f);
-
-        for (const auto& [cell, boxes] : box_map) {
-          for (const Obstacle* box : boxes) {
-            box->draw(lightingShader);
-            if(box->contains(player.getPos())){
-              playSound(explosion);
-              game_over = true;
-            }
-          }
+        glfwPollEvents();
+        if(keyPressed(window, GLFW_KEY_F3)){
+          hud.toggle();
         }
-
-        lightingShader.setVec3("objectColor", 0.5f, 0.5f, 0.5f);
-        Planet* last = nullptr;
-        for(Planet& planet : planets){
-          if(last != nullptr){
-            planet.updatePos(last->getPos());
-          }
-
-          brightShader.use();
-          /*
-          player.applyForce(
-              glm::normalize(planet.getPos() - player.getPos()),
-              glm::clamp(planet.gravity / (glm::distance(planet.getPos(), player.getPos()) * 0.4f), 0.0f, 1.0f)
-              );
-          */
-          player.requestOrbit(planet.getPos(), planet.gravity * 20.0f);
-          lightingShader.use();
-          planet.draw();
-          if(planet.contains(player.getPos())){
-            game_over = true;
+        // F9 dumps the last frames for chrome://tracing or ui.perfetto.dev
+        if(keyPressed(window, GLFW_KEY_F9) && writeChromeTrace("boids_trace.json")){
+          std::cout << std::endl << "Wrote boids_trace.json" << std::endl;
+        }
+        // F5 checkpoints the session in the background, F6 jumps back to it.
+        // Not while replaying, the recorded inputs only fit the recorded states.
+        if(!replaying && keyPressed(window, GLFW_KEY_F5)){
+          snapshots.save(world, "boids_snapshot.bin");
+        }
+        if(!replaying && keyPressed(window, GLFW_KEY_F6)){
+          std::string error;
+          // Where the recording ends if the restore changes the world
+          uint64_t recorded = recorder.isOpen() ? world.checksum() : 0;
+          bool restored = snapshots.wait() && restoreSnapshot(world, "boids_snapshot.bin", error);
+          // A streaming restore evicts chunks, the next step clears the list before a draw
+          renderer.forgetEvicted(world);
+          if(!restored)
+            std::cerr << std::endl << "Snapshot: " << (error.empty() ? snapshots.getError() : error) << std::endl;
+          // A checksum mismatch fails after the world was replaced, that ends the recording too.
+          // A replay starts from the seed, it can't jump to a snapshot.
+          if(recorder.isOpen() && (restored || world.checksum() != recorded)){
+            std::cerr << std::endl << "Replay: stopped recording at the restore" << std::endl;
+            if(!recorder.close(recorded))
+              std::cerr << "Replay: " << recorder.getError() << std::endl;
           }
-          last = &planet;
         }
-
-
-        brightShader.setVec3("objectColor", 1.0f, 1.0f, 0.0f);
-        brightShader.use();
-        player.updatePos(cameraFront);
-        player.draw(boid_map, brightShader, frames_since_shot, shot_cooldown);
-
-        processInput(window, player, boid_map);
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-        if(game_over){
+        if(world.game_over){
           playSound(explosion);
           std::this_thread::sleep_for(std::chrono::seconds(1));
         }
@@ -252,6 +270,28 @@ int main() {
     }
 
 
+    // Every input played or the game ended, the session ended there too if the two agree
+    if(replaying && (replayTick == replay.getInputs().size() || world.game_over)){
+      if(replay.checkEnd(world))
+        std::cout << std::endl << "Replay: ended on the recorded checksum" << std::endl;
+      else
+        std::cerr << std::endl << "Replay: " << replay.getError() << std::endl;
+    }
+    if(recorder.isOpen()){
+      uint64_t ticks = recorder.getTickCount();
+      if(recorder.close(world.checksum()))
+        std::cout << std::endl << "Recorded " << ticks << " ticks to " << recordPath << std::endl;
+      else
+        std::cerr << std::endl << "Replay: " << recorder.getError() << std::endl;
+    }
+    writeChromeTrace("boids_trace.json");
+    // Frame time percentiles, hitches and the histogram for capacity reports
+    timer.writeJson("frame_times.json");
+    timer.writeCsv("frame_times.csv");
+    {
+      std::ofstream gpu_times("gpu_times.json");
+      renderer.getGpuTimer().writeJson(gpu_times);
+    }
     glfwDestroyWindow(window);
     glfwTerminate();
     Mix_CloseAudio();
@@ -260,4 +300,3 @@ int main() {
     std::cout << std::endl << "Quitting..." << std::endl;
     return 0;
 }
-
@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 uv;
+in vec4 color;
+
+// Glyph atlas, one channel, rectangles sample its solid texel
+uniform sampler2D atlas;
+
+void main()
+{
+	float coverage = texture(atlas, uv).r;
+	if (coverage < 0.5)
+		discard;
+	FragColor = color;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec4 aPosUv;
+layout (location = 1) in vec4 aColor;
+
+// Window size in pixels, positions come in with the origin top left
+uniform vec2 screen;
+
+out vec2 uv;
+out vec4 color;
+
+void main()
+{
+	vec2 ndc = aPosUv.xy / screen * 2.0 - 1.0;
+	gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+	uv = aPosUv.zw;
+	color = aColor;
+}
@@ -0,0 +1,76 @@
+// Bakes the fixed world (generateRandomBoxes, Space's asteroids and stars and
+// the obstacle distance field) into a chunk store the game maps at startup.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "utils/scenario.h"
+#include "utils/world.h"
+#include "utils/chunk_store.h"
+
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " OUT [--scenario PATH] [--seed N] [--chunk-size S]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string outPath = argv[1];
+
+    Scenario scenario;
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--scenario") == 0 && hasValue) {
+            if (!loadScenario(argv[++i], scenario))
+                return 1;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            scenario.world.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--chunk-size") == 0 && hasValue) {
+            scenario.world.chunks.size = std::strtof(argv[++i], nullptr);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // The world as it is built without streaming, boxes, asteroids and field included
+    WorldConfig config = scenario.world;
+    config.streaming = false;
+    config.initialBoids = 0;
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    World world(config);
+    double generateMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    std::string error;
+    start = clock::now();
+    if (!writeChunkStore(outPath, config.seed, config.chunks.size, world.box_map,
+            world.space.getStars(), world.obstacle_field, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    double writeMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    ChunkStore store;
+    if (!store.open(outPath)) {
+        std::cerr << "wrote " << outPath << " but it does not read back: " << store.getError() << std::endl;
+        return 1;
+    }
+    const ChunkStoreHeader& header = store.getHeader();
+    size_t obstacles = 0;
+    for (const auto& [cell, cellObstacles] : world.box_map) {
+        obstacles += cellObstacles.size();
+    }
+    std::printf("%s: %u chunks of %.0f, %zu obstacles, %zu stars, %zu bricks, %.1f MB\n",
+        outPath.c_str(), header.chunk_count, header.chunk_size, obstacles, world.space.getStars().size(),
+        world.obstacle_field.brickCount(), header.file_size / double(1 << 20));
+    std::printf("generated in %.1f ms, written in %.1f ms\n", generateMs, writeMs);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Packs the assets and shaders into one archive the game maps at startup, see
+// utils/asset_archive.h.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "utils/asset_archive.h"
+
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " OUT [--root DIR] [SUBDIR...]" << std::endl
+        << "packs every file under DIR/SUBDIR (default root .., assets and shaders)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string outPath = argv[1];
+    std::string root = "..";
+    std::vector<std::string> dirs;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else if (argv[i][0] != '-') {
+            dirs.push_back(argv[i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (dirs.empty())
+        dirs = {"assets", "shaders"};
+
+    // Names relative to root with forward slashes, the way loaders spell them
+    std::vector<std::string> names;
+    for (const std::string& dir : dirs) {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(root + "/" + dir, error);
+                it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (error)
+                break;
+            if (it->is_regular_file())
+                names.push_back(std::filesystem::relative(it->path(), root).generic_string());
+        }
+        if (error) {
+            std::cerr << "could not list " << root << "/" << dir << ": " << error.message() << std::endl;
+            return 1;
+        }
+    }
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    std::string error;
+    if (!writeAssetArchive(outPath, root, names, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    double writeMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    AssetArchive archive;
+    if (!archive.open(outPath) || !archive.verify(error)) {
+        std::cerr << "wrote " << outPath << " but it does not read back: "
+            << (archive.isOpen() ? error : archive.getError()) << std::endl;
+        return 1;
+    }
+    std::printf("%s: %u assets, %.1f MB, written in %.1f ms\n", outPath.c_str(), archive.count(),
+        std::filesystem::file_size(outPath) / double(1 << 20), writeMs);
+    return 0;
+}
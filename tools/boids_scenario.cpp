@@ -0,0 +1,320 @@
+// Headless scenario runner: steps a World through a scripted scenario and reports
+// per-phase timing percentiles, peak memory and the final state checksum.
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include "utils/scenario.h"
+#include "utils/profiler.h"
+#include "utils/world.h"
+#include "utils/snapshot.h"
+#include "utils/replay.h"
+
+struct PhaseStats {
+    double p50, p90, p99, max, mean;
+};
+
+// Nearest-rank percentiles, times in milliseconds
+static PhaseStats summarize(std::vector<double> samples) {
+    PhaseStats stats = {0, 0, 0, 0, 0};
+    if (samples.empty())
+        return stats;
+    std::sort(samples.begin(), samples.end());
+    auto rank = [&](double p) {
+        size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+        return samples[std::min(index, samples.size() - 1)];
+    };
+    double sum = 0.0;
+    for (double s : samples) {
+        sum += s;
+    }
+    stats.p50 = rank(0.50);
+    stats.p90 = rank(0.90);
+    stats.p99 = rank(0.99);
+    stats.max = samples.back();
+    stats.mean = sum / samples.size();
+    return stats;
+}
+
+static long peakRssKb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return usage.ru_maxrss;   // kilobytes on Linux
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " SCENARIO [--ticks N] [--json PATH] [--trace PATH] [--perf]"
+        << " [--restore PATH] [--save-at FRAME PATH] [--record PATH] [--replay PATH] [--check]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Scenario scenario;
+    if (!loadScenario(argv[1], scenario))
+        return 1;
+
+    std::string jsonPath;
+    std::string tracePath;
+    std::string restorePath;
+    std::string savePath;
+    std::string recordPath;
+    std::string replayPath;
+    long saveAt = -1;
+    // A pinned checksum only holds for the toolchain it was recorded with, so
+    // a different one fails the run only when asked for
+    bool check = false;
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            scenario.ticks = std::strtol(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--perf") == 0) {
+            scenario.world.perfCounters = true;
+        } else if (std::strcmp(argv[i], "--restore") == 0 && hasValue) {
+            restorePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--save-at") == 0 && i + 2 < argc) {
+            saveAt = std::strtol(argv[++i], nullptr, 10);
+            savePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0 && hasValue) {
+            recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Recorded inputs replace the scripted path, the scenario still sets up the world
+    ReplayReader replay;
+    if (!replayPath.empty()) {
+        if (!replay.open(replayPath)) {
+            std::cerr << replay.getError() << std::endl;
+            return 1;
+        }
+        replay.apply(scenario.world);
+        scenario.seed = scenario.world.seed;
+        if (!replay.checkStore(scenario.world)) {
+            std::cerr << replay.getError() << std::endl;
+            return 1;
+        }
+    }
+    ReplayRecorder recorder;
+    if (!recordPath.empty())
+        recorder.open(recordPath, scenario.world);
+
+    // Zones are only worth recording when someone asked for the trace
+    profilerSetEnabled(!tracePath.empty());
+
+    typedef std::chrono::steady_clock clock;
+    clock::time_point setupStart = clock::now();
+    World world(scenario.world);
+    if (!scenario.world.chunks.storePath.empty() && !world.chunks.getStore().isOpen())
+        std::cerr << "chunk store: " << world.chunks.getStore().getError() << ", generating chunks instead" << std::endl;
+    double setupMs = std::chrono::duration<double, std::milli>(clock::now() - setupStart).count();
+
+    // Starts from a warmed up state, ticks then counts from the restored frame
+    if (!restorePath.empty()) {
+        clock::time_point restoreStart = clock::now();
+        std::string error;
+        if (!restoreSnapshot(world, restorePath, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        std::fprintf(stderr, "restored frame %ld from %s in %.2f ms\n", world.frame, restorePath.c_str(),
+            std::chrono::duration<double, std::milli>(clock::now() - restoreStart).count());
+    }
+    SnapshotSaver saver;
+
+    std::vector<double> phaseMs[PHASE_COUNT];
+    std::vector<double> stepMs;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        phaseMs[p].reserve(scenario.ticks);
+    }
+    stepMs.reserve(scenario.ticks);
+
+    // Summed per phase over the run, reported as means per tick
+    PerfSample counterTotals[PHASE_COUNT];
+    // Work counters, the max per tick shows blowups the mean hides
+    CounterSample workTotals, workMax;
+
+    long tick = 0;
+    int peakBoids = 0;
+    uint64_t boidTicks = 0;
+    for (; tick < scenario.ticks && !world.game_over; tick++) {
+        // Indexed by frame, so a replay also lines up with a restored snapshot
+        if (!replayPath.empty() && size_t(world.frame) >= replay.getInputs().size())
+            break;
+        if (world.frame == saveAt)
+            saver.save(world, savePath);
+        PlayerInput input = replayPath.empty()
+            ? scriptedInput(scenario, world, world.frame)
+            : replay.getInputs()[world.frame];
+        recorder.record(input);
+
+        clock::time_point start = clock::now();
+        world.step(input);
+        stepMs.push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            phaseMs[p].push_back(world.phase_seconds[p] * 1000.0);
+            for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+                counterTotals[p].values[c] += world.phase_counters[p].values[c];
+            }
+        }
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            workTotals.values[c] += world.frame_counters.values[c];
+            workMax.values[c] = std::max(workMax.values[c], world.frame_counters.values[c]);
+        }
+        peakBoids = std::max(peakBoids, world.num_boids);
+        boidTicks += world.num_boids;
+    }
+
+    if (world.frame == saveAt)
+        saver.save(world, savePath);
+    if (saveAt >= 0 && !saver.wait())
+        std::cerr << "snapshot: " << saver.getError() << std::endl;
+    if (recorder.isOpen()) {
+        uint64_t ticks = recorder.getTickCount();
+        size_t bytes = recorder.getByteCount();
+        // A recording that started from a snapshot has no seed run to end on
+        bool closed = restorePath.empty() ? recorder.close(world.checksum()) : recorder.close();
+        if (closed)
+            std::fprintf(stderr, "recorded %llu ticks to %s, %zu bytes of input\n",
+                static_cast<unsigned long long>(ticks), recordPath.c_str(), bytes);
+        else
+            std::cerr << recorder.getError() << std::endl;
+    }
+
+    char checksum[17];
+    std::snprintf(checksum, sizeof(checksum), "%016" PRIx64, world.checksum());
+    bool checksumMatches = scenario.checksum.empty() || scenario.checksum == checksum;
+    // Every recorded input played (or the game ended as it did in the session)
+    bool replayEnded = !replayPath.empty()
+        && (size_t(world.frame) >= replay.getInputs().size() || world.game_over);
+    bool replayMatches = !replayEnded || replay.checkEnd(world);
+    long rssKb = peakRssKb();
+
+    // Human readable report
+    std::fprintf(stderr, "scenario %s: %ld ticks, seed %u, setup %.1f ms\n",
+        scenario.name.c_str(), tick, scenario.seed, setupMs);
+    std::fprintf(stderr, "%-18s %10s %10s %10s %10s %10s\n", "phase (ms)", "p50", "p90", "p99", "max", "mean");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        PhaseStats s = summarize(phaseMs[p]);
+        std::fprintf(stderr, "%-18s %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+            worldPhaseName(static_cast<world_phase_t>(p)), s.p50, s.p90, s.p99, s.max, s.mean);
+    }
+    PhaseStats total = summarize(stepMs);
+    std::fprintf(stderr, "%-18s %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+        "step", total.p50, total.p90, total.p99, total.max, total.mean);
+    std::fprintf(stderr, "%-18s %14s %14s\n", "work (per tick)", "mean", "max");
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        std::fprintf(stderr, "%-18s %14.1f %14llu\n", counterName(static_cast<counter_t>(c)),
+            tick > 0 ? static_cast<double>(workTotals.values[c]) / tick : 0.0,
+            static_cast<unsigned long long>(workMax.values[c]));
+    }
+    // How much of the stepping the flock tier took over
+    double farCellShare = workTotals.values[COUNTER_CELLS_TOUCHED]
+        ? 100.0 * workTotals.values[COUNTER_FAR_FLOCKS] / workTotals.values[COUNTER_CELLS_TOUCHED] : 0.0;
+    double farBoidShare = boidTicks ? 100.0 * workTotals.values[COUNTER_FAR_FLOCK_BOIDS] / boidTicks : 0.0;
+    std::fprintf(stderr, "far flocks %.1f%% of cells, %.1f%% of boids\n", farCellShare, farBoidShare);
+
+    bool counted = world.perf.isOpen() && tick > 0;
+    if (counted) {
+        std::fprintf(stderr, "%-18s", "phase (per tick)");
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+            std::fprintf(stderr, " %14s", perfCounterName(static_cast<perf_counter_t>(c)));
+        }
+        std::fprintf(stderr, " %6s\n", "ipc");
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            const uint64_t* v = counterTotals[p].values;
+            std::fprintf(stderr, "%-18s", worldPhaseName(static_cast<world_phase_t>(p)));
+            for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+                std::fprintf(stderr, " %14.0f", static_cast<double>(v[c]) / tick);
+            }
+            std::fprintf(stderr, " %6.2f\n", v[PERF_CYCLES] ? static_cast<double>(v[PERF_INSTRUCTIONS]) / v[PERF_CYCLES] : 0.0);
+        }
+    } else if (scenario.world.perfCounters) {
+        std::fprintf(stderr, "hardware counters unavailable: %s\n", world.perf.getError().c_str());
+    }
+    std::fprintf(stderr, "boids %d (peak %d), peak rss %ld KB, game over %s\n",
+        world.num_boids, peakBoids, rssKb, world.game_over ? "yes" : "no");
+    std::fprintf(stderr, "checksum %s%s\n", checksum,
+        scenario.checksum.empty() ? "" : (checksumMatches ? " (matches)"
+            : (check ? " (MISMATCH, expected " : " (differs from the pinned ") + scenario.checksum + ")").c_str());
+    if (!replayMatches)
+        std::fprintf(stderr, "replay MISMATCH: %s\n", replay.getError().c_str());
+
+    if (!tracePath.empty() && !writeChromeTrace(tracePath)) {
+        std::cerr << "Could not write " << tracePath << std::endl;
+        return 1;
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        if (!out) {
+            std::cerr << "Could not write " << jsonPath << std::endl;
+            return 1;
+        }
+        auto writeStats = [&](const char* name, const PhaseStats& s, bool last) {
+            out << "    \"" << name << "\": {\"p50\": " << s.p50 << ", \"p90\": " << s.p90
+                << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << ", \"mean\": " << s.mean << "}"
+                << (last ? "" : ",") << "\n";
+        };
+        out << "{\n  \"scenario\": \"" << scenario.name << "\",\n"
+            << "  \"seed\": " << scenario.seed << ",\n"
+            << "  \"ticks\": " << tick << ",\n"
+            << "  \"setup_ms\": " << setupMs << ",\n"
+            << "  \"phases_ms\": {\n";
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            writeStats(worldPhaseName(static_cast<world_phase_t>(p)), summarize(phaseMs[p]), false);
+        }
+        writeStats("step", total, true);
+        out << "  },\n";
+        if (counted) {
+            out << "  \"counters_per_tick\": {\n";
+            for (int p = 0; p < PHASE_COUNT; p++) {
+                out << "    \"" << worldPhaseName(static_cast<world_phase_t>(p)) << "\": {";
+                for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+                    out << (c == 0 ? "" : ", ") << "\"" << perfCounterName(static_cast<perf_counter_t>(c)) << "\": "
+                        << static_cast<double>(counterTotals[p].values[c]) / tick;
+                }
+                out << "}" << (p + 1 < PHASE_COUNT ? "," : "") << "\n";
+            }
+            out << "  },\n";
+        }
+        out << "  \"work_per_tick\": {\n";
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            out << "    \"" << counterName(static_cast<counter_t>(c)) << "\": {\"mean\": "
+                << (tick > 0 ? static_cast<double>(workTotals.values[c]) / tick : 0.0)
+                << ", \"max\": " << workMax.values[c] << "}" << (c + 1 < COUNTER_COUNT ? "," : "") << "\n";
+        }
+        out << "  },\n";
+        out << "  \"boids\": " << world.num_boids << ",\n"
+            << "  \"peak_boids\": " << peakBoids << ",\n"
+            << "  \"peak_rss_kb\": " << rssKb << ",\n"
+            << "  \"game_over\": " << (world.game_over ? "true" : "false") << ",\n"
+            << "  \"checksum\": \"" << checksum << "\"\n"
+            << "}\n";
+    }
+
+    return (checksumMatches || !check) && replayMatches ? 0 : 2;
+}